@@ -0,0 +1,111 @@
+#!/bin/bash
+#
+# Benchmark de throughput del compilador.
+#
+# Genera programas sintéticos de varias formas y tamaños con genprog, los
+# compila con -ftime-report-json y muestra el tiempo de cada fase, líneas/s
+# y nodos/s. La columna "ns/nodo" compara el costo por nodo con el tamaño
+# anterior de la misma forma: si crece con la escala hay algo superlineal.
+#
+# Variables:
+#   CALC      compilador a medir (por defecto ../src/calc)
+#   OUT       directorio de trabajo y resultados (por defecto out)
+#   REPEAT    corridas por programa, se queda con la más rápida (3)
+#   SHAPES    formas a medir (funcs block expr nest calls)
+#   SIZES_<forma>  tamaños para esa forma, p.ej. SIZES_block="1000 5000"
+#
+# Los resultados quedan también en $OUT/results.csv.
+
+set -e
+cd "$(dirname "$0")"
+
+CALC=$(realpath "${CALC:-../src/calc}")
+OUT=${OUT:-out}
+REPEAT=${REPEAT:-3}
+SHAPES=${SHAPES:-"funcs block expr nest calls"}
+
+: "${SIZES_funcs:=500 2000 8000}"
+: "${SIZES_block:=2000 10000 50000}"
+: "${SIZES_expr:=1000 5000 20000}"
+# la pila del parser (YYMAXDEPTH de bison, 10000) limita el anidamiento
+: "${SIZES_nest:=100 400 1200}"
+: "${SIZES_calls:=500 2000 8000}"
+
+if [ ! -x "$CALC" ]; then
+    echo "No se encontró el compilador en $CALC (compilar con src/run.sh)" >&2
+    exit 1
+fi
+
+mkdir -p "$OUT"
+gcc -O2 -o "$OUT/genprog" genprog.c
+cd "$OUT"
+
+PHASES="lex parse semantic fold tac asm"
+CSV=results.csv
+echo "shape,size,lines,nodes,total_ms,lex_ms,parse_ms,semantic_ms,fold_ms,tac_ms,asm_ms,lines_per_s,nodes_per_s" > $CSV
+
+# valor de un campo de una fase en el JSON de -ftime-report-json
+phase_field() {  # archivo fase campo
+    awk -v ph="\"$2\"" -v f="\"$3\":" '
+        index($0, "\"name\": " ph) {
+            for (i = 1; i <= NF; i++) if ($i == f) { v = $(i+1); gsub(/[,}]/, "", v); print v }
+        }' "$1"
+}
+
+total_ms() {
+    awk '/"total_ms"/ { v = $2; gsub(/,/, "", v); print v }' "$1"
+}
+
+printf "%-6s %7s %8s %9s %10s" forma tamaño lineas nodos "total ms"
+for p in $PHASES; do printf " %9s" "$p"; done
+printf " %12s %12s %8s\n" "lineas/s" "nodos/s" "ns/nodo"
+
+for shape in $SHAPES; do
+    sizes_var="SIZES_$shape"
+    prev_ns=""
+    for size in ${!sizes_var}; do
+        src="$shape-$size.c"
+        ./genprog "$shape" "$size" > "$src"
+        lines=$(wc -l < "$src")
+
+        best=""
+        for r in $(seq "$REPEAT"); do
+            if ! "$CALC" -ftime-report-json=run.json "$src" > /dev/null 2> "$shape-$size.err"; then
+                best="FAIL"
+                break
+            fi
+            t=$(total_ms run.json)
+            if [ -z "$best" ] || awk -v a="$t" -v b="$best" 'BEGIN { exit !(a < b) }'; then
+                best=$t
+                cp run.json "$shape-$size.json"
+            fi
+        done
+
+        if [ "$best" = "FAIL" ]; then
+            printf "%-6s %7s %8s  falló la compilación (ver %s/%s)\n" \
+                "$shape" "$size" "$lines" "$OUT" "$shape-$size.err"
+            prev_ns=""
+            continue
+        fi
+
+        json="$shape-$size.json"
+        nodes=$(phase_field "$json" parse count)
+        row="$shape,$size,$lines,$nodes,$best"
+        printf "%-6s %7s %8s %9s %10.2f" "$shape" "$size" "$lines" "$nodes" "$best"
+        for p in $PHASES; do
+            ms=$(phase_field "$json" "$p" ms)
+            row="$row,$ms"
+            printf " %9.2f" "$ms"
+        done
+
+        read lps nps ns <<< "$(awk -v l="$lines" -v n="$nodes" -v t="$best" 'BEGIN {
+            s = t / 1000; if (s <= 0) s = 1e-9
+            printf "%.0f %.0f %.1f", l / s, n / s, t * 1e6 / (n > 0 ? n : 1) }')"
+        growth=""
+        [ -n "$prev_ns" ] && growth=$(awk -v a="$ns" -v b="$prev_ns" 'BEGIN { printf "(x%.2f)", a / b }')
+        printf " %12s %12s %8s %s\n" "$lps" "$nps" "$ns" "$growth"
+        echo "$row,$lps,$nps" >> $CSV
+        prev_ns=$ns
+    done
+done
+rm -f run.json out.s
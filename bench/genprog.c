@@ -0,0 +1,134 @@
+/* Generador de programas sintéticos para medir el compilador.
+ *
+ * Uso: genprog <forma> <escala> [semilla]
+ *
+ * Formas:
+ *   funcs   <escala> funciones chicas con un while cada una
+ *   block   un main con un bloque de <escala> sentencias
+ *   expr    expresiones encadenadas de <escala> operadores (árbol profundo)
+ *   nest    if/while anidados <escala> niveles
+ *   calls   cadena de <escala> funciones, cada una llama a la anterior
+ *
+ * Los programas respetan la gramática actual: los nombres de variables son
+ * únicos en todo el programa (hay un solo scope) y las llamadas usan a lo sumo
+ * un argumento.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned long rng_state = 1;
+
+static int rnd(int n) {
+    rng_state = rng_state * 6364136223846793005UL + 1442695040888963407UL;
+    return (int)((rng_state >> 33) % (unsigned long)n);
+}
+
+static const char* arith_op(void) {
+    static const char* ops[] = { "+", "-", "*", "/", "%" };
+    return ops[rnd(5)];
+}
+
+static void gen_funcs(int n) {
+    for (int k = 0; k < n; k++) {
+        printf("integer f%d(integer p%d)\n{\n", k, k);
+        printf("    integer a%d = %d;\n", k, 10 + rnd(90));
+        printf("    integer b%d = a%d * %d + 1;\n", k, k, 1 + rnd(9));
+        printf("    while (a%d > 0)\n    {\n", k);
+        printf("        a%d = a%d - 1;\n", k, k);
+        printf("        b%d = b%d + a%d %% %d;\n", k, k, k, 2 + rnd(7));
+        printf("    }\n");
+        printf("    return b%d;\n}\n\n", k);
+    }
+    printf("void main()\n{\n");
+    printf("    integer r = f%d(1);\n", n > 0 ? n - 1 : 0);
+    printf("    return;\n}\n");
+}
+
+static void gen_block(int n) {
+    printf("void main()\n{\n");
+    printf("    integer x = 0;\n    integer y = 1;\n    bool c = true;\n");
+    for (int i = 0; i < n; i++) {
+        switch (rnd(4)) {
+            case 0: printf("    x = x + y * %d - %d;\n", 1 + rnd(9), rnd(100)); break;
+            case 1: printf("    y = x / %d + y %s %d;\n", 1 + rnd(9), arith_op(), 1 + rnd(9)); break;
+            case 2: printf("    c = x > y && !c;\n"); break;
+            default:
+                printf("    if (c) then { x = x - 1; } else { y = y + 1; }\n");
+        }
+    }
+    printf("    return;\n}\n");
+}
+
+static void gen_expr(int n) {
+    printf("void main()\n{\n");
+    printf("    integer x = 1;\n    integer y = 2;\n    bool c = true;\n");
+    printf("    x = x\n");
+    for (int i = 0; i < n; i++)
+        printf("        %s %s\n", arith_op(), rnd(2) ? "y" : "3");
+    printf("        ;\n");
+    printf("    c = c\n");
+    for (int i = 0; i < n / 2; i++)
+        printf("        %s x < %d\n", rnd(2) ? "&&" : "||", rnd(100));
+    printf("        ;\n");
+    printf("    return;\n}\n");
+}
+
+static void indent(int d) {
+    for (int i = 0; i < d; i++) fputs("  ", stdout);
+}
+
+static void gen_nest(int n) {
+    printf("void main()\n{\n");
+    printf("    integer x = 0;\n    bool c = true;\n");
+    for (int d = 0; d < n; d++) {
+        indent(d + 2);
+        if (d % 2 == 0) printf("if (c) then {\n");
+        else            printf("while (c) {\n");
+        indent(d + 3);
+        printf("x = x + %d;\n", 1 + rnd(9));
+        indent(d + 3);
+        printf("c = x < %d;\n", 100 + rnd(100));
+    }
+    for (int d = n - 1; d >= 0; d--) {
+        indent(d + 2);
+        printf("}\n");
+    }
+    printf("    return;\n}\n");
+}
+
+static void gen_calls(int n) {
+    printf("integer f0(integer p0)\n{\n    return 1;\n}\n\n");
+    for (int k = 1; k < n; k++) {
+        printf("integer f%d(integer p%d)\n{\n", k, k);
+        printf("    integer v%d = f%d(%d);\n", k, k - 1, rnd(100));
+        printf("    return v%d + 1;\n}\n\n", k);
+    }
+    printf("void main()\n{\n");
+    printf("    integer r = f%d(0);\n", n > 1 ? n - 1 : 0);
+    printf("    return;\n}\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Uso: %s funcs|block|expr|nest|calls <escala> [semilla]\n", argv[0]);
+        return 1;
+    }
+    const char* shape = argv[1];
+    int n = atoi(argv[2]);
+    rng_state = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+
+    printf("// generado: %s %d\n", shape, n);
+    printf("Program\n{\n");
+    if      (strcmp(shape, "funcs") == 0) gen_funcs(n);
+    else if (strcmp(shape, "block") == 0) gen_block(n);
+    else if (strcmp(shape, "expr") == 0)  gen_expr(n);
+    else if (strcmp(shape, "nest") == 0)  gen_nest(n);
+    else if (strcmp(shape, "calls") == 0) gen_calls(n);
+    else {
+        fprintf(stderr, "Forma desconocida: %s\n", shape);
+        return 1;
+    }
+    printf("}\n");
+    return 0;
+}
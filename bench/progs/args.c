@@ -0,0 +1,26 @@
+// Llamadas con más de seis argumentos (los últimos van por la pila).
+Program
+{
+integer get_int() extern;
+void print_int(integer i) extern;
+
+integer pondera(integer a, integer b, integer c, integer d,
+                integer e, integer f, integer g, integer h)
+{
+    return a + b * 2 + c * 3 + d * 4 + e * 5 + f * 6 + g * 7 + h * 8;
+}
+
+void main()
+{
+    integer n = get_int();
+    integer i = 0;
+    integer acc = 0;
+    while (i < n)
+    {
+        acc = pondera(i, 1, 2, 3, 4, 5, 6, acc % 7) + acc;
+        acc = acc % 1000003;
+        i = i + 1;
+    }
+    print_int(acc);
+}
+}
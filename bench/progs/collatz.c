@@ -0,0 +1,37 @@
+// Lazo con saltos poco predecibles: largo total de las secuencias de Collatz.
+Program
+{
+integer get_int() extern;
+void print_int(integer i) extern;
+
+integer pasos(integer n)
+{
+    integer k = 0;
+    while (n > 1)
+    {
+        if (n % 2 == 0) then
+        {
+            n = n / 2;
+        }
+        else
+        {
+            n = 3 * n + 1;
+        }
+        k = k + 1;
+    }
+    return k;
+}
+
+void main()
+{
+    integer n = get_int();
+    integer i = 1;
+    integer total = 0;
+    while (i < n)
+    {
+        total = total + pasos(i);
+        i = i + 1;
+    }
+    print_int(total);
+}
+}
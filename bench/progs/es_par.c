@@ -0,0 +1,34 @@
+// Paridad por conteo (la función es_par de tests/validos/entrada.c):
+// cuenta los pares menores que n, O(n^2) iteraciones de un while chico.
+Program
+{
+integer get_int() extern;
+void print_int(integer i) extern;
+
+bool es_par(integer n)
+{
+    bool resultado = true;
+    while (n > 0)
+    {
+        resultado = !resultado;
+        n = n - 1;
+    }
+    return resultado;
+}
+
+void main()
+{
+    integer limite = get_int();
+    integer i = 0;
+    integer pares = 0;
+    while (i < limite)
+    {
+        if (es_par(i)) then
+        {
+            pares = pares + 1;
+        }
+        i = i + 1;
+    }
+    print_int(pares);
+}
+}
@@ -0,0 +1,20 @@
+// Recursión pura: fibonacci ingenuo.
+Program
+{
+integer get_int() extern;
+void print_int(integer i) extern;
+
+integer fib(integer n)
+{
+    if (n < 2) then
+    {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+void main()
+{
+    print_int(fib(get_int()));
+}
+}
@@ -0,0 +1,29 @@
+// Muchas llamadas chicas con varios argumentos en un lazo.
+Program
+{
+integer get_int() extern;
+void print_int(integer i) extern;
+
+integer suma(integer a, integer b)
+{
+    return a + b;
+}
+
+integer mezcla(integer a, integer b, integer c)
+{
+    return suma(a * 3, b) % 99991 + c;
+}
+
+void main()
+{
+    integer n = get_int();
+    integer i = 0;
+    integer acc = 1;
+    while (i < n)
+    {
+        acc = mezcla(acc, i, 1);
+        i = i + 1;
+    }
+    print_int(acc);
+}
+}
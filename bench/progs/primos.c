@@ -0,0 +1,40 @@
+// Aritmética y lazos anidados: primos por división de prueba.
+Program
+{
+integer get_int() extern;
+void print_int(integer i) extern;
+
+bool es_primo(integer n)
+{
+    integer d = 2;
+    if (n < 2) then
+    {
+        return false;
+    }
+    while (d * d < n + 1)
+    {
+        if (n % d == 0) then
+        {
+            return false;
+        }
+        d = d + 1;
+    }
+    return true;
+}
+
+void main()
+{
+    integer n = get_int();
+    integer i = 0;
+    integer cuenta = 0;
+    while (i < n)
+    {
+        if (es_primo(i)) then
+        {
+            cuenta = cuenta + 1;
+        }
+        i = i + 1;
+    }
+    print_int(cuenta);
+}
+}
@@ -0,0 +1,111 @@
+#!/bin/bash
+#
+# Benchmark del código generado.
+#
+# Compila cada programa de bench/progs con cada compilador y cada nivel de
+# optimización, lo enlaza con bench/runtime.c (get_int, print_int y los
+# contadores), lo corre con su .in y verifica la salida contra .expected.
+# De REPEAT corridas se queda con la más rápida y muestra, por programa, una
+# tabla con tiempo, ciclos, instrucciones, saltos e IPC, y la relación de
+# tiempo contra la primera configuración.
+#
+# Variables:
+#   COMPILERS  lista "nombre=ruta" de compiladores (actual=../src/calc)
+#   BASE_REV   revisión de git a compilar y agregar como "base" al principio
+#   OPTS       niveles de optimización a probar ("-O0 -O1 -O2")
+#   PROGS      programas a correr (todos los de progs/)
+#   REPEAT     corridas por configuración (3)
+#   OUT        directorio de trabajo (out-run)
+#
+# Los contadores de hardware dependen de perf_event_open; si el kernel no
+# los da (p.ej. en una máquina virtual) esas columnas quedan en "-".
+# Los resultados quedan también en $OUT/results.csv.
+
+set -e
+cd "$(dirname "$0")"
+BENCH=$(pwd)
+
+OUT=${OUT:-out-run}
+OPTS=${OPTS:-"-O0 -O1 -O2"}
+REPEAT=${REPEAT:-3}
+COMPILERS=${COMPILERS:-"actual=$BENCH/../src/calc"}
+PROGS=${PROGS:-$(cd progs && ls *.c | sed 's/\.c$//')}
+
+mkdir -p "$OUT"
+OUT=$(realpath "$OUT")
+
+# compila una revisión anterior igual que src/run.sh, sin correr los tests
+if [ -n "$BASE_REV" ]; then
+    rm -rf "$OUT/base-src"
+    mkdir -p "$OUT/base-src"
+    git -C "$BENCH/.." archive "$BASE_REV" src | tar -x -C "$OUT/base-src"
+    (cd "$OUT/base-src/src" && flex calc-lexico.l && bison -d calc-sintaxis.y 2>/dev/null &&
+     gcc -O2 -o calc *.c -lfl -lpthread)
+    COMPILERS="base=$OUT/base-src/src/calc $COMPILERS"
+fi
+
+gcc -O2 -c runtime.c -o "$OUT/runtime.o"
+
+CSV="$OUT/results.csv"
+echo "program,compiler,opt,ok,wall_ms,task_clock_ms,cycles,instructions,branches,branch_misses" > "$CSV"
+
+stat_of() {  # archivo nombre
+    awk -v k="$2" '$1 == k { print $2 }' "$1"
+}
+
+for prog in $PROGS; do
+    echo "== $prog"
+    printf "  %-10s %-4s %10s %14s %14s %14s %6s %8s  %s\n" \
+        compilador opt ms ciclos instrucciones saltos IPC "vs 1ra" salida
+    first_ms=""
+    for comp in $COMPILERS; do
+        name=${comp%%=*}
+        calc=$(realpath "${comp#*=}")
+        for opt in $OPTS; do
+            work="$OUT/$prog-$name$opt"
+            rm -rf "$work" && mkdir -p "$work"
+            if ! (cd "$work" && "$calc" $opt "$BENCH/progs/$prog.c" > compile.out 2> compile.err) ||
+               [ ! -s "$work/out.s" ] ||
+               ! gcc -o "$work/prog" "$work/out.s" "$OUT/runtime.o" 2> "$work/link.err"; then
+                printf "  %-10s %-4s  no compila (ver %s)\n" "$name" "$opt" "$work"
+                echo "$prog,$name,$opt,compile-error,,,,,," >> "$CSV"
+                continue
+            fi
+
+            best=""
+            ok=ok
+            for r in $(seq "$REPEAT"); do
+                # el main del lenguaje es void: el código de salida no significa nada
+                BENCH_STATS="$work/run.stats" "$work/prog" < "progs/$prog.in" > "$work/run.out" || true
+                cmp -s "$work/run.out" "progs/$prog.expected" || ok=MAL
+                [ -s "$work/run.stats" ] || { ok=MAL; break; }
+                ns=$(stat_of "$work/run.stats" wall_ns)
+                if [ -z "$best" ] || [ "$ns" -lt "$best" ]; then
+                    best=$ns
+                    cp "$work/run.stats" "$work/best.stats"
+                fi
+            done
+            if [ -z "$best" ]; then
+                printf "  %-10s %-4s  falló la ejecución (ver %s)\n" "$name" "$opt" "$work"
+                echo "$prog,$name,$opt,run-error,,,,,," >> "$CSV"
+                continue
+            fi
+
+            s="$work/best.stats"
+            ms=$(awk -v n="$best" 'BEGIN { printf "%.2f", n / 1e6 }')
+            task=$(stat_of "$s" task_clock_ns)
+            cyc=$(stat_of "$s" cycles)
+            ins=$(stat_of "$s" instructions)
+            br=$(stat_of "$s" branches)
+            miss=$(stat_of "$s" branch_misses)
+            ipc=$(awk -v c="$cyc" -v i="$ins" 'BEGIN { if (c > 0) printf "%.2f", i / c; else print "-" }')
+            [ -z "$first_ms" ] && first_ms=$ms
+            rel=$(awk -v a="$ms" -v b="$first_ms" 'BEGIN { printf "x%.2f", a / b }')
+
+            printf "  %-10s %-4s %10s %14s %14s %14s %6s %8s  %s\n" \
+                "$name" "$opt" "$ms" "${cyc:--}" "${ins:--}" "${br:--}" "$ipc" "$rel" "$ok"
+            task_ms=$(awk -v n="$task" 'BEGIN { if (n != "") printf "%.2f", n / 1e6 }')
+            echo "$prog,$name,$opt,$ok,$ms,$task_ms,$cyc,$ins,$br,$miss" >> "$CSV"
+        done
+    done
+done
@@ -0,0 +1,93 @@
+/* Runtime mínimo para ejecutar el out.s que genera el compilador.
+ *
+ * Provee las funciones extern que usan los programas (get_int, print_int) y,
+ * si la variable de entorno BENCH_STATS nombra un archivo, mide la corrida
+ * como lo haría `perf stat`: abre contadores con perf_event_open antes de
+ * main y al salir escribe una línea "nombre valor" por cada contador que el
+ * kernel haya permitido abrir (en máquinas virtuales suele no haber
+ * contadores de hardware; el tiempo siempre está).
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+int get_int(void) {
+    int v;
+    if (scanf("%d", &v) != 1) return 0;
+    return v;
+}
+
+void print_int(int v) {
+    printf("%d\n", v);
+}
+
+/* ---------- contadores ---------- */
+
+typedef struct {
+    const char* name;
+    unsigned type;
+    unsigned long long config;
+    int fd;
+} Counter;
+
+static Counter counters[] = {
+    { "task_clock_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK,        -1 },
+    { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,        -1 },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,      -1 },
+    { "branches",      PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, -1 },
+    { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,     -1 },
+};
+#define NCOUNTERS (sizeof(counters) / sizeof(counters[0]))
+
+static const char* stats_path;
+static struct timespec start_time;
+
+static long long elapsed_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_time.tv_sec) * 1000000000LL + (now.tv_nsec - start_time.tv_nsec);
+}
+
+static void stats_stop(void) {
+    long long wall = elapsed_ns();
+    for (unsigned i = 0; i < NCOUNTERS; i++)
+        if (counters[i].fd >= 0) ioctl(counters[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    FILE* f = fopen(stats_path, "w");
+    if (!f) { perror(stats_path); return; }
+    fprintf(f, "wall_ns %lld\n", wall);
+    for (unsigned i = 0; i < NCOUNTERS; i++) {
+        unsigned long long v;
+        if (counters[i].fd >= 0 && read(counters[i].fd, &v, sizeof(v)) == sizeof(v))
+            fprintf(f, "%s %llu\n", counters[i].name, v);
+    }
+    fclose(f);
+}
+
+__attribute__((constructor))
+static void stats_start(void) {
+    stats_path = getenv("BENCH_STATS");
+    if (!stats_path || !*stats_path) return;
+
+    for (unsigned i = 0; i < NCOUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counters[i].type;
+        attr.config = counters[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counters[i].fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    atexit(stats_stop);
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    for (unsigned i = 0; i < NCOUNTERS; i++)
+        if (counters[i].fd >= 0) ioctl(counters[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+}
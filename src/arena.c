@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+/* lo más exigente que se guarda en una arena son punteros (nodos del AST,
+   arrays de hijos) y texto: alinear a max_align_t (16) llevaría cada nodo
+   de 24 bytes a 32 */
+#define ARENA_ALIGN      (sizeof(void*))
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static ArenaBlock* arena_new_block(Arena* a, size_t min_size) {
+    size_t size = min_size > ARENA_BLOCK_SIZE ? min_size : ARENA_BLOCK_SIZE;
+    ArenaBlock* b = malloc(sizeof(ArenaBlock) + size);
+    if (!b) { perror("malloc"); exit(1); }
+    b->used = 0;
+    b->size = size;
+    b->next = a->head;
+    a->head = b;
+    a->reserved += size;
+    return b;
+}
+
+void arena_init(Arena* a) {
+    a->head = NULL;
+    a->last = NULL;
+    a->reserved = 0;
+}
+
+void* arena_alloc(Arena* a, size_t size) {
+    size = align_up(size ? size : 1);
+    ArenaBlock* b = a->head;
+    if (!b || b->size - b->used < size)
+        b = arena_new_block(a, size);
+    void* p = (char*)b->data + b->used;
+    b->used += size;
+    a->last = p;
+    return p;
+}
+
+/* Si old es la última asignación y hay lugar en el bloque, crece sin copiar */
+void* arena_realloc(Arena* a, void* old, size_t old_size, size_t new_size) {
+    if (!old) return arena_alloc(a, new_size);
+    if (new_size <= old_size) return old;
+
+    ArenaBlock* b = a->head;
+    if (old == a->last && b) {
+        size_t start = (size_t)((char*)old - (char*)b->data);
+        size_t need = align_up(new_size);
+        if (start + need <= b->size) {
+            b->used = start + need;
+            return old;
+        }
+    }
+    void* p = arena_alloc(a, new_size);
+    memcpy(p, old, old_size);
+    return p;
+}
+
+char* arena_strdup(Arena* a, const char* s) {
+    size_t len = strlen(s) + 1;
+    char* p = arena_alloc(a, len);
+    memcpy(p, s, len);
+    return p;
+}
+
+ArenaMark arena_mark(Arena* a) {
+    ArenaMark m = { a->head, a->head ? a->head->used : 0 };
+    return m;
+}
+
+void arena_reset(Arena* a, ArenaMark m) {
+    while (a->head != m.head) {
+        ArenaBlock* b = a->head;
+        a->head = b->next;
+        a->reserved -= b->size;
+        free(b);
+    }
+    if (a->head) a->head->used = m.used;
+    a->last = NULL;
+}
+
+void arena_free(Arena* a) {
+    ArenaBlock* b = a->head;
+    while (b) {
+        ArenaBlock* tmp = b;
+        b = b->next;
+        free(tmp);
+    }
+    arena_init(a);
+}
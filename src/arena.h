@@ -0,0 +1,38 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+/* ---------- Arena de memoria ----------
+ * Reserva bloques grandes y reparte memoria de forma lineal.
+ * No hay liberación individual: todo se devuelve junto con arena_free.
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    max_align_t data[];     // memoria utilizable (alineada)
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock *head;       // bloque actual (el más reciente)
+    void *last;             // última asignación (permite crecer in situ)
+    size_t reserved;        // bytes pedidos al sistema
+} Arena;
+
+void  arena_init(Arena* a);
+void* arena_alloc(Arena* a, size_t size);
+void* arena_realloc(Arena* a, void* old, size_t old_size, size_t new_size);
+char* arena_strdup(Arena* a, const char* s);
+void  arena_free(Arena* a);
+
+/* Posición de la arena para volver atrás: arena_reset libera todo lo
+   asignado después de arena_mark y conserva lo anterior */
+typedef struct ArenaMark {
+    ArenaBlock *head;
+    size_t used;
+} ArenaMark;
+
+ArenaMark arena_mark(Arena* a);
+void  arena_reset(Arena* a, ArenaMark m);
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include "asmbuf.h"
+
+#define ASMBUF_MIN_CAP 4096
+
+void asmbuf_grow(AsmBuf* b, size_t extra) {
+    size_t cap = b->cap ? b->cap : ASMBUF_MIN_CAP;
+    while (cap < b->len + extra) cap *= 2;
+    if (cap == b->cap) return;
+    b->data = realloc(b->data, cap);
+    if (!b->data) { perror("realloc"); exit(1); }
+    b->cap = cap;
+}
+
+void asmbuf_int(AsmBuf* b, long v) {
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    unsigned long u = v < 0 ? -(unsigned long)v : (unsigned long)v;
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (v < 0) *--p = '-';
+    asmbuf_put(b, p, tmp + sizeof(tmp) - p);
+}
+
+void asmbuf_printf(AsmBuf* b, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (b->len + n + 1 > b->cap) asmbuf_grow(b, n + 1);
+    va_start(ap, fmt);
+    vsnprintf(b->data + b->len, n + 1, fmt, ap);
+    va_end(ap);
+    b->len += n;
+}
+
+void asmbuf_append(AsmBuf* dst, const AsmBuf* src) {
+    if (src->len) asmbuf_put(dst, src->data, src->len);
+}
+
+static int write_all(int fd, const char* p, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, p + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+int asmbuf_flush_fd(AsmBuf* b, int fd) {
+    int r = write_all(fd, b->data, b->len);
+    b->len = 0;
+    return r;
+}
+
+int asmbuf_write_file(const AsmBuf* b, const char* path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) return -1;
+    if (write_all(fd, b->data, b->len) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return close(fd);
+}
+
+char* asmbuf_take(AsmBuf* b, size_t* len) {
+    asmbuf_putc(b, '\0');
+    char* s = b->data;
+    if (len) *len = b->len - 1;
+    b->data = NULL;
+    b->len = b->cap = 0;
+    return s;
+}
+
+void asmbuf_free(AsmBuf* b) {
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
@@ -0,0 +1,53 @@
+#ifndef ASMBUF_H
+#define ASMBUF_H
+#include <stddef.h>
+#include <string.h>
+
+/* ---------- Buffer de salida del assembly ----------
+ * Todo el texto generado se acumula en memoria (crece al doble) y se
+ * escribe de una sola vez al final, o queda en el buffer para quien use el
+ * compilador como biblioteca. Las funciones de escritura frecuentes son
+ * inline y no interpretan formatos.
+ */
+typedef struct AsmBuf {
+    char *data;
+    size_t len;
+    size_t cap;
+} AsmBuf;
+
+void asmbuf_grow(AsmBuf* b, size_t extra);   /* asegura lugar para extra bytes más */
+
+static inline void asmbuf_put(AsmBuf* b, const char* s, size_t n) {
+    if (b->len + n > b->cap) asmbuf_grow(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+static inline void asmbuf_puts(AsmBuf* b, const char* s) {
+    asmbuf_put(b, s, strlen(s));
+}
+
+static inline void asmbuf_putc(AsmBuf* b, char c) {
+    if (b->len + 1 > b->cap) asmbuf_grow(b, 1);
+    b->data[b->len++] = c;
+}
+
+void asmbuf_int(AsmBuf* b, long v);                      /* entero en decimal */
+void asmbuf_printf(AsmBuf* b, const char* fmt, ...)      /* caso general, lento */
+    __attribute__((format(printf, 2, 3)));
+void asmbuf_append(AsmBuf* dst, const AsmBuf* src);
+
+/* escribe todo el contenido en fd y deja el buffer vacío (conserva la
+   capacidad); 0 si salió bien, -1 y errno si no */
+int asmbuf_flush_fd(AsmBuf* b, int fd);
+
+/* escribe todo el contenido en path con un único write (reintenta si el
+   sistema escribe de a partes); 0 si salió bien, -1 y errno si no */
+int asmbuf_write_file(const AsmBuf* b, const char* path);
+
+/* entrega el texto (terminado en '\0') al llamador, que lo libera con free;
+   el buffer queda vacío */
+char* asmbuf_take(AsmBuf* b, size_t* len);
+void asmbuf_free(AsmBuf* b);
+
+#endif
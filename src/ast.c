@@ -1,152 +1,217 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "ast.h"
+#include "arena.h"
 
-static ASTNode* new_node(NodeType t) {
-    ASTNode* n = malloc(sizeof(ASTNode));
+void* ast_alloc(AstPool* pool, size_t size) {
+    return arena_alloc(&pool->arena, size);
+}
+
+ASTNode** ast_alloc_children(AstPool* pool, int count) {
+    return arena_alloc(&pool->arena, sizeof(ASTNode*) * count);
+}
+
+/* Asegura lugar para `need` elementos duplicando la capacidad. Como el
+   array suele ser lo último reservado en la arena, casi siempre crece en
+   el lugar sin copiar. */
+static void nodelist_reserve(AstPool* pool, NodeList* l, int need) {
+    if (need <= l->cap) return;
+    int cap = l->cap ? l->cap : 8;
+    while (cap < need) cap <<= 1;
+    l->items = arena_realloc(&pool->arena, l->items,
+                             sizeof(ASTNode*) * l->cap, sizeof(ASTNode*) * cap);
+    l->cap = cap;
+}
+
+void nodelist_push(AstPool* pool, NodeList* l, ASTNode* n) {
+    nodelist_reserve(pool, l, l->count + 1);
+    l->items[l->count++] = n;
+}
+
+/* Agrega al final de dst los elementos de src (src queda vacía) */
+void nodelist_append(AstPool* pool, NodeList* dst, NodeList* src) {
+    if (src->count == 0) return;
+    if (dst->count == 0) {
+        *dst = *src;
+    } else {
+        nodelist_reserve(pool, dst, dst->count + src->count);
+        memcpy(dst->items + dst->count, src->items, sizeof(ASTNode*) * src->count);
+        dst->count += src->count;
+    }
+    src->items = NULL;
+    src->count = src->cap = 0;
+}
+
+/* Entrega el array de la lista (sin copiar) y la deja vacía */
+ASTNode** nodelist_take(NodeList* l, int* count) {
+    ASTNode** items = l->count > 0 ? l->items : NULL;
+    *count = l->count;
+    l->items = NULL;
+    l->count = l->cap = 0;
+    return items;
+}
+
+/* Libera de una vez todo lo reservado para el AST */
+void ast_release(AstPool* pool) {
+    arena_free(&pool->arena);
+}
+
+ArenaMark ast_mark(AstPool* pool) {
+    return arena_mark(&pool->arena);
+}
+
+void ast_reset(AstPool* pool, ArenaMark m) {
+    arena_reset(&pool->arena, m);
+}
+
+/* Los nombres que reciben los constructores ya están internados (los interna
+   el analizador léxico), así que se guardan sin duplicar. */
+static ASTNode* new_node(AstPool* pool, NodeType t) {
+    ASTNode* n = arena_alloc(&pool->arena, sizeof(ASTNode));
+    pool->node_count++;
     n->type = t;
-    n->id = NULL;
-    n->op = NULL;
-    n->ival = 0;
-    n->left = n->right = NULL;
-    n->children = NULL;
-    n->child_count = 0;
+    n->op = OP_NONE;
     n->vtype = TYPE_VOID;
+    n->child_count = 0;
+    n->left = NULL;
+    n->right = NULL;
     return n;
 }
 
-ASTNode* make_int_node(int val) {
-    ASTNode* n = new_node(NODE_INT);
+ASTNode* make_int_node(AstPool* pool, int val) {
+    ASTNode* n = new_node(pool, NODE_INT);
     n->ival = val;
     return n;
 }
 
-ASTNode* make_bool_node(int val) {
-    ASTNode* n = new_node(NODE_BOOL);
+ASTNode* make_bool_node(AstPool* pool, int val) {
+    ASTNode* n = new_node(pool, NODE_BOOL);
     n->ival = val;
     return n;
 }
 
-ASTNode* make_id_node(char* name) {
-    ASTNode* n = new_node(NODE_ID);
-    n->id = strdup(name);
+ASTNode* make_id_node(AstPool* pool, const char* name) {
+    ASTNode* n = new_node(pool, NODE_ID);
+    n->id = name;
     return n;
 }
 
-ASTNode* make_binop_node(char* op, ASTNode* l, ASTNode* r) {
-    ASTNode* n = new_node(NODE_BINOP);
-    n->op = strdup(op);
+ASTNode* make_binop_node(AstPool* pool, OpKind op, ASTNode* l, ASTNode* r) {
+    ASTNode* n = new_node(pool, NODE_BINOP);
+    n->op = op;
     n->left = l;
     n->right = r;
     return n;
 }
 
-ASTNode* make_unop_node(char* op, ASTNode* expr) {
-    ASTNode* n = new_node(NODE_UNOP);
-    n->op = strdup(op);
+ASTNode* make_unop_node(AstPool* pool, OpKind op, ASTNode* expr) {
+    ASTNode* n = new_node(pool, NODE_UNOP);
+    n->op = op;
     n->left = expr;
     return n;
 }
 
-ASTNode* make_assign_node(ASTNode* id, ASTNode* expr) {
-    ASTNode* n = new_node(NODE_ASSIGN);
+ASTNode* make_assign_node(AstPool* pool, ASTNode* id, ASTNode* expr) {
+    ASTNode* n = new_node(pool, NODE_ASSIGN);
     n->left = id;
     n->right = expr;
     return n;
 }
 
-ASTNode* make_return_node(ASTNode* expr) {
-    ASTNode* n = new_node(NODE_RETURN);
+/* declaración con inicialización: se genera igual que una asignación, pero
+   marca la variable como propia del bloque (local o global) */
+ASTNode* make_decl_node(AstPool* pool, ASTNode* id, ASTNode* init) {
+    ASTNode* n = new_node(pool, NODE_DECL);
+    n->left = id;
+    n->right = init;
+    n->vtype = id->vtype;
+    return n;
+}
+
+ASTNode* make_return_node(AstPool* pool, ASTNode* expr) {
+    ASTNode* n = new_node(pool, NODE_RETURN);
     n->left = expr;
     return n;
 }
 
-ASTNode* make_if_node(ASTNode* cond, ASTNode* then_b, ASTNode* else_b) {
-    ASTNode* n = new_node(NODE_IF);
+ASTNode* make_if_node(AstPool* pool, ASTNode* cond, ASTNode* then_b, ASTNode* else_b) {
+    ASTNode* n = new_node(pool, NODE_IF);
     n->left = cond; // condición
     n->child_count = else_b ? 2 : 1;
-    n->children = malloc(sizeof(ASTNode*) * n->child_count);
+    n->children = ast_alloc_children(pool, n->child_count);
     n->children[0] = then_b;
     if (else_b) n->children[1] = else_b;
     return n;
 }
 
-ASTNode* make_while_node(ASTNode* cond, ASTNode* body) {
-    ASTNode* n = new_node(NODE_WHILE);
+ASTNode* make_while_node(AstPool* pool, ASTNode* cond, ASTNode* body) {
+    ASTNode* n = new_node(pool, NODE_WHILE);
     n->left = cond;
     n->right = body;
     return n;
 }
 
-ASTNode* make_block_node(ASTNode** stmts, int count) {
-    ASTNode* n = new_node(NODE_BLOCK);
-    n->child_count = count;
-    if (count > 0) {
-        n->children = malloc(sizeof(ASTNode*) * count);
-        for (int i = 0; i < count; i++) n->children[i] = stmts[i];
-    }
+ASTNode* make_block_node(AstPool* pool, NodeList* stmts) {
+    ASTNode* n = new_node(pool, NODE_BLOCK);
+    n->children = nodelist_take(stmts, &n->child_count);
     return n;
 }
 
-ASTNode* make_prog_node(ASTNode** decls, int dcount, ASTNode** stmts, int scount) {
-    ASTNode* n = new_node(NODE_PROG);
-    n->children = malloc((dcount + scount) * sizeof(ASTNode*));
-    for (int i = 0; i < dcount; i++) n->children[i] = decls[i];
-    for (int j = 0; j < scount; j++) n->children[dcount + j] = stmts[j];
-    n->child_count = dcount + scount;
+ASTNode* make_prog_node(AstPool* pool, NodeList* decls) {
+    ASTNode* n = new_node(pool, NODE_PROG);
+    n->children = nodelist_take(decls, &n->child_count);
     return n;
 }
 
-ASTNode* make_param_node(VarType tipo, char* name) {
-    ASTNode* n = new_node(NODE_PARAM);
-    n->id = strdup(name);
+ASTNode* make_param_node(AstPool* pool, VarType tipo, const char* name) {
+    ASTNode* n = new_node(pool, NODE_PARAM);
+    n->id = name;
     n->vtype = tipo;
     return n;
 }
 
-ASTNode* make_func_node(VarType tipo, char* name, ASTNode** params, int param_count, ASTNode* body) {
-    ASTNode* n = new_node(NODE_FUNC);
-    n->id = strdup(name);
+/* children = parámetros seguidos del cuerpo */
+ASTNode* make_func_node(AstPool* pool, VarType tipo, const char* name, NodeList* params, ASTNode* body) {
+    ASTNode* n = new_node(pool, NODE_FUNC);
+    n->id = name;
     n->vtype = tipo;
-
-    // cantidad total = parámetros + cuerpo (si hay)
-    int count = param_count + (body ? 1 : 0);
-
-    if (count > 0) {
-        n->children = malloc(sizeof(ASTNode*) * count);
-        int i = 0;
-        for (; i < param_count; i++) {
-            n->children[i] = params[i];
-        }
-        if (body)
-            n->children[i] = body;
-        n->child_count = count;
-    }
-
-    n->left = NULL;
-    n->right = NULL;
+    if (body)
+        nodelist_push(pool, params, body);
+    n->children = nodelist_take(params, &n->child_count);
     return n;
 }
 
-ASTNode* make_extern_func_node(VarType tipo, char* name, ASTNode** params, int param_count) {
-    ASTNode* n = new_node(NODE_EXTERN_FUNC);
-    n->id = strdup(name);
+ASTNode* make_extern_func_node(AstPool* pool, VarType tipo, const char* name, NodeList* params) {
+    ASTNode* n = new_node(pool, NODE_EXTERN_FUNC);
+    n->id = name;
     n->vtype = tipo;
-    n->children = params;
-    n->child_count = param_count;
+    n->children = nodelist_take(params, &n->child_count);
     return n;
 }
 
-ASTNode* make_func_call_node(char* name, ASTNode** args, int arg_count) {
+ASTNode* make_func_call_node(AstPool* pool, const char* name, NodeList* args) {
     //ASTNode* n = new_node(NODE_FUNC);
-    ASTNode* n = new_node(NODE_FUNC_CALL);
-    n->id = strdup(name);
-    n->children = args;
-    n->child_count = arg_count;
+    ASTNode* n = new_node(pool, NODE_FUNC_CALL);
+    n->id = name;
+    n->children = nodelist_take(args, &n->child_count);
     return n;
 }
 
+/* Tabla única de símbolos de operadores (AST, TAC y mensajes) */
+static const char* const op_symbols[OP_COUNT] = {
+    [OP_NONE] = "?",
+    [OP_ADD] = "+", [OP_SUB] = "-", [OP_MUL] = "*", [OP_DIV] = "/", [OP_MOD] = "%",
+    [OP_LT] = "<", [OP_GT] = ">", [OP_EQ] = "==",
+    [OP_AND] = "&&", [OP_OR] = "||",
+    [OP_NOT] = "!", [OP_NEG] = "-",
+};
+
+const char* op_symbol(OpKind op) {
+    return (op >= 0 && op < OP_COUNT) ? op_symbols[op] : "?";
+}
+
 /* Print AST */
 void print_ast(ASTNode* node, int indent) {
     if (!node) return;
@@ -156,9 +221,10 @@ void print_ast(ASTNode* node, int indent) {
         case NODE_INT:   	printf("INT %d\n", node->ival); break;
         case NODE_BOOL:  	printf("BOOL %s\n", node->ival ? "true" : "false"); break;
         case NODE_ID:    	printf("ID %s\n", node->id); break;
-        case NODE_BINOP: 	printf("BINOP %s\n", node->op); break;
-        case NODE_UNOP:  	printf("UNOP %s\n", node->op); break;
+        case NODE_BINOP: 	printf("BINOP %s\n", op_symbol(node->op)); break;
+        case NODE_UNOP:  	printf("UNOP %s\n", op_symbol(node->op)); break;
         case NODE_ASSIGN:	printf("ASSIGN\n"); break;
+        case NODE_DECL:  	printf("DECL\n"); break;
         case NODE_RETURN:	printf("RETURN\n"); break;
         case NODE_FUNC:         printf("FUNC %s\n", node->id); break;
         case NODE_EXTERN_FUNC:  printf("EXTERN FUNC %s\n", node->id); break;    
@@ -170,36 +236,23 @@ void print_ast(ASTNode* node, int indent) {
         default:         	printf("UNKNOWN\n");
     }
 
-    if (node->left) print_ast(node->left, indent+1);
-    if (node->right) print_ast(node->right, indent+1);
+    if (ast_left(node)) print_ast(node->left, indent+1);
+    if (ast_right(node)) print_ast(node->right, indent+1);
     for (int i=0; i<node->child_count; i++) {
         print_ast(node->children[i], indent+1);
     }
 }
 
-void free_ast(ASTNode* node) {
-    if (!node) return;
-    free(node->id);
-    free(node->op);
-    free_ast(node->left);
-    free_ast(node->right);
-    for (int i=0;i<node->child_count;i++) {
-        free_ast(node->children[i]);
-    }
-    free(node->children);
-    free(node);
-}
-
-ASTNode* fold_constants(ASTNode* node) {
+ASTNode* fold_constants(AstPool* pool, ASTNode* node) {
     if (!node) return NULL;
 
     // Aplicar recursivamente
-    if (node->left)
-        node->left = fold_constants(node->left);
-    if (node->right)
-        node->right = fold_constants(node->right);
+    if (ast_left(node))
+        node->left = fold_constants(pool, node->left);
+    if (ast_right(node))
+        node->right = fold_constants(pool, node->right);
     for (int i = 0; i < node->child_count; i++)
-        node->children[i] = fold_constants(node->children[i]);
+        node->children[i] = fold_constants(pool, node->children[i]);
 
     // Operaciones binarias entre constantes
     if (node->type == NODE_BINOP &&
@@ -211,46 +264,77 @@ ASTNode* fold_constants(ASTNode* node) {
         int result;
         int valid = 1;
 
-        if (strcmp(node->op, "+") == 0) result = a + b;
-        else if (strcmp(node->op, "-") == 0) result = a - b;
-        else if (strcmp(node->op, "*") == 0) result = a * b;
-        else if (strcmp(node->op, "/") == 0) {
-            if (b == 0) valid = 0;
-            else result = a / b;
-        } else if (strcmp(node->op, "==") == 0) result = (a == b);
-        else if (strcmp(node->op, "!=") == 0) result = (a != b);
-        else if (strcmp(node->op, "<") == 0) result = (a < b);
-        else if (strcmp(node->op, ">") == 0) result = (a > b);
-        else if (strcmp(node->op, "<=") == 0) result = (a <= b);
-        else if (strcmp(node->op, ">=") == 0) result = (a >= b);
-        else valid = 0;
+        switch (node->op) {
+            case OP_ADD: result = a + b; break;
+            case OP_SUB: result = a - b; break;
+            case OP_MUL: result = a * b; break;
+            case OP_DIV:
+                if (b == 0) valid = 0;
+                else result = a / b;
+                break;
+            case OP_EQ:  result = (a == b); break;
+            case OP_LT:  result = (a < b); break;
+            case OP_GT:  result = (a > b); break;
+            default:     valid = 0;
+        }
 
         if (valid) {
             node->type = NODE_INT;
-            node->ival = result;
-            free(node->op);
-            node->op = NULL;
-            free_ast(node->left);
-            free_ast(node->right);
-            node->left = node->right = NULL;
-            node->child_count = 0;
+            node->op = OP_NONE;
+            node->right = NULL;
+            node->ival = result;    // ocupa el lugar de left
+            pool->folded_count++;
         }
     }
 
     // Operaciones unarias sobre constantes
     if (node->type == NODE_UNOP &&
         node->left && node->left->type == NODE_BOOL) {
-        if (strcmp(node->op, "!") == 0) {
+        if (node->op == OP_NOT) {
             int val = node->left->ival;
             node->type = NODE_BOOL;
-            node->ival = !val;
-            free(node->op);
-            node->op = NULL;
-            free_ast(node->left);
+            node->op = OP_NONE;
             node->left = NULL;
+            node->ival = !val;
+            pool->folded_count++;
         }
     }
 
     return node;
 }
 
+int ast_const_value(const ASTNode* node, int* value) {
+    if (!node) return 0;
+    if (node->type == NODE_INT || node->type == NODE_BOOL) {
+        *value = node->ival;
+        return 1;
+    }
+    int a, b;
+    if (node->type == NODE_UNOP) {
+        if (!ast_const_value(node->left, &a)) return 0;
+        *value = node->op == OP_NOT ? !a
+               : node->op == OP_NEG ? (int)(0u - (unsigned)a) : a;
+        return 1;
+    }
+    if (node->type != NODE_BINOP ||
+        !ast_const_value(node->left, &a) || !ast_const_value(node->right, &b))
+        return 0;
+    /* como idivl: sin división por cero ni INT_MIN / -1 */
+    if ((node->op == OP_DIV || node->op == OP_MOD) &&
+        (b == 0 || (a == INT_MIN && b == -1)))
+        return 0;
+    switch (node->op) {
+        case OP_ADD: *value = (int)((unsigned)a + (unsigned)b); break;
+        case OP_SUB: *value = (int)((unsigned)a - (unsigned)b); break;
+        case OP_MUL: *value = (int)((unsigned)a * (unsigned)b); break;
+        case OP_DIV: *value = a / b; break;
+        case OP_MOD: *value = a % b; break;
+        case OP_LT:  *value = a < b; break;
+        case OP_GT:  *value = a > b; break;
+        case OP_EQ:  *value = a == b; break;
+        case OP_AND: *value = a && b; break;
+        case OP_OR:  *value = a || b; break;
+        default:     return 0;
+    }
+    return 1;
+}
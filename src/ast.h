@@ -1,5 +1,7 @@
 #ifndef AST_H
 #define AST_H
+#include <stddef.h>
+#include "arena.h"
 
 typedef enum {
     NODE_INT, NODE_BOOL, NODE_ID,
@@ -14,39 +16,118 @@ typedef enum {
 
 typedef enum { TYPE_INT, TYPE_BOOL, TYPE_VOID } VarType;
 
+/* Operadores de expresión (binarios y unarios) */
+typedef enum {
+    OP_NONE,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_LT, OP_GT, OP_EQ,
+    OP_AND, OP_OR,
+    OP_NOT, OP_NEG,
+    OP_COUNT
+} OpKind;
+
+/* Nodo del AST en 24 bytes: cada tipo usa solo los campos que le tocan y
+   los que nunca conviven comparten lugar.
+     ival      INT, BOOL
+     id        ID, PARAM, FUNC, EXTERN_FUNC, FUNC_CALL
+     left      BINOP, UNOP, ASSIGN, DECL, RETURN, IF (condición), WHILE (condición)
+     right     BINOP, ASSIGN, DECL, WHILE (cuerpo)
+     children  IF (ramas), BLOCK, PROG, FUNC (parámetros y cuerpo),
+               EXTERN_FUNC, FUNC_CALL (argumentos)
+   child_count vale 0 en los tipos sin lista. Un recorrido que no distingue
+   tipos usa ast_left/ast_right, que dan NULL donde el campo no existe. */
 typedef struct ASTNode {
-    NodeType type;
-    char *id;           // nombre de variable o función
-    int ival;           // para literales enteros o bool
-    char *op;           // operador (+, -, *, ==, etc.)
-    VarType vtype;      // tipo de variable o función
-    struct ASTNode *left, *right;   // hijos binarios
-    struct ASTNode **children;      // para listas (bloques, parámetros)
+    unsigned char type;     // NodeType
+    unsigned char op;       // OpKind (+, -, *, ==, etc.)
+    unsigned char vtype;    // VarType: tipo de la expresión, variable o función
     int child_count;
+    union {
+        int ival;                   // literales enteros o bool
+        const char *id;             // nombre de variable o función (internado)
+        struct ASTNode *left;       // operando o condición
+    };
+    union {
+        struct ASTNode *right;      // segundo operando o cuerpo del while
+        struct ASTNode **children;  // listas (bloques, parámetros, argumentos)
+    };
 } ASTNode;
 
+#define AST_KIND(k) (1u << (k))
+#define AST_LEFT_KINDS  (AST_KIND(NODE_BINOP) | AST_KIND(NODE_UNOP) | AST_KIND(NODE_ASSIGN) | \
+                         AST_KIND(NODE_DECL) | AST_KIND(NODE_RETURN) | AST_KIND(NODE_IF) | \
+                         AST_KIND(NODE_WHILE))
+#define AST_RIGHT_KINDS (AST_KIND(NODE_BINOP) | AST_KIND(NODE_ASSIGN) | AST_KIND(NODE_DECL) | \
+                         AST_KIND(NODE_WHILE))
+#define AST_ID_KINDS    (AST_KIND(NODE_ID) | AST_KIND(NODE_PARAM) | AST_KIND(NODE_FUNC) | \
+                         AST_KIND(NODE_EXTERN_FUNC) | AST_KIND(NODE_FUNC_CALL))
+
+static inline ASTNode* ast_left(const ASTNode* n) {
+    return (AST_LEFT_KINDS & AST_KIND(n->type)) ? n->left : NULL;
+}
+
+static inline ASTNode* ast_right(const ASTNode* n) {
+    return (AST_RIGHT_KINDS & AST_KIND(n->type)) ? n->right : NULL;
+}
+
+static inline const char* ast_id(const ASTNode* n) {
+    return (AST_ID_KINDS & AST_KIND(n->type)) ? n->id : NULL;
+}
+
+/* Memoria de un AST: nodos y arrays de hijos viven en una arena que se
+   libera de una vez al terminar la compilación (una AstPool en cero está
+   lista para usar) */
+typedef struct AstPool {
+    Arena arena;
+    long node_count;        // nodos creados (para -ftime-report)
+    long folded_count;      // nodos reemplazados por una constante
+} AstPool;
+
+/* Lista de nodos en construcción (reglas de listas del parser). Crece
+   geométricamente dentro de la arena del AST; los constructores que la
+   reciben se quedan con su array sin copiarlo y la dejan vacía. */
+typedef struct NodeList {
+    ASTNode** items;
+    int count;
+    int cap;
+} NodeList;
+
+void nodelist_push(AstPool* pool, NodeList* l, ASTNode* n);
+void nodelist_append(AstPool* pool, NodeList* dst, NodeList* src);
+ASTNode** nodelist_take(NodeList* l, int* count);
+
 /* Constructores */
-ASTNode* make_int_node(int val);
-ASTNode* make_bool_node(int val);
-ASTNode* make_id_node(char* name);
-ASTNode* make_binop_node(char* op, ASTNode* l, ASTNode* r);
-ASTNode* make_unop_node(char* op, ASTNode* expr);
-ASTNode* make_assign_node(ASTNode* id, ASTNode* expr);
-ASTNode* make_return_node(ASTNode* expr);
-ASTNode* make_if_node(ASTNode* cond, ASTNode* then_b, ASTNode* else_b);
-ASTNode* make_while_node(ASTNode* cond, ASTNode* body);
-ASTNode* make_block_node(ASTNode** stmts, int count);
-ASTNode* make_prog_node(ASTNode** decls, int dcount, ASTNode** stmts, int scount);
-ASTNode* make_func_node(VarType tipo, char* name, ASTNode** params, int param_count, ASTNode* body);
-ASTNode* make_extern_func_node(VarType tipo, char* name, ASTNode** params, int param_count);
-ASTNode* make_param_node(VarType tipo, char* name);
-ASTNode* make_extern_func_node(VarType tipo, char* name, ASTNode** params, int param_count);
-ASTNode* make_func_call_node(char* name, ASTNode** args, int arg_count);
-ASTNode* fold_constants(ASTNode* node);
+ASTNode* make_int_node(AstPool* pool, int val);
+ASTNode* make_bool_node(AstPool* pool, int val);
+ASTNode* make_id_node(AstPool* pool, const char* name);
+ASTNode* make_binop_node(AstPool* pool, OpKind op, ASTNode* l, ASTNode* r);
+ASTNode* make_unop_node(AstPool* pool, OpKind op, ASTNode* expr);
+ASTNode* make_assign_node(AstPool* pool, ASTNode* id, ASTNode* expr);
+ASTNode* make_decl_node(AstPool* pool, ASTNode* id, ASTNode* init);
+ASTNode* make_return_node(AstPool* pool, ASTNode* expr);
+ASTNode* make_if_node(AstPool* pool, ASTNode* cond, ASTNode* then_b, ASTNode* else_b);
+ASTNode* make_while_node(AstPool* pool, ASTNode* cond, ASTNode* body);
+ASTNode* make_block_node(AstPool* pool, NodeList* stmts);
+ASTNode* make_prog_node(AstPool* pool, NodeList* decls);
+ASTNode* make_func_node(AstPool* pool, VarType tipo, const char* name, NodeList* params, ASTNode* body);
+ASTNode* make_extern_func_node(AstPool* pool, VarType tipo, const char* name, NodeList* params);
+ASTNode* make_param_node(AstPool* pool, VarType tipo, const char* name);
+ASTNode* make_func_call_node(AstPool* pool, const char* name, NodeList* args);
+ASTNode* fold_constants(AstPool* pool, ASTNode* node);
+/* valor de una expresión sin variables ni llamadas, con la aritmética de 32
+   bits del código generado; 0 si no es constante o divide por cero */
+int ast_const_value(const ASTNode* node, int* value);
+
+/* Memoria del AST */
+void* ast_alloc(AstPool* pool, size_t size);
+ASTNode** ast_alloc_children(AstPool* pool, int count);
+void ast_release(AstPool* pool);
+/* libera solo los nodos creados después de ast_mark (modo streaming) */
+ArenaMark ast_mark(AstPool* pool);
+void ast_reset(AstPool* pool, ArenaMark m);
 
 /* Utilidades */
+const char* op_symbol(OpKind op);
 void print_ast(ASTNode* node, int indent);
-void free_ast(ASTNode* node);
 
 #endif
 
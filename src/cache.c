@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "codegen.h"
+#include "parallel.h"
+
+/* Cambiar cuando cambie el assembly que se genera para un mismo AST: las
+   entradas viejas dejan de coincidir y se regeneran */
+#define CACHE_VERSION "calc-cache-7"
+
+/* Una unidad: la función y las declaraciones globales que la siguen (la
+   primera unidad puede ser solo globales: esa no se guarda) */
+typedef struct CacheUnit {
+    ASTNode **nodes;
+    int count;
+    int cacheable;          // empieza en una función
+    uint64_t hash;
+    AsmBuf text;            // etiquetas numeradas desde 0
+    GlobalVar *globals;     // nombres internados
+    int nglobals;
+    int labels;             // etiquetas .L usadas
+    int asm_labels;         // etiquetas .LASM usadas
+    TacList code;           // TAC de una unidad que no estaba en la caché
+    GenCounters gen;
+} CacheUnit;
+
+/* ---------- Hash estructural (FNV-1a de 64 bits) ---------- */
+static void hash_bytes(uint64_t* h, const void* p, size_t n) {
+    const unsigned char* b = p;
+    for (size_t i = 0; i < n; i++) {
+        *h ^= b[i];
+        *h *= 0x100000001b3ULL;
+    }
+}
+
+static void hash_int(uint64_t* h, long v) {
+    hash_bytes(h, &v, sizeof(v));
+}
+
+static void hash_str(uint64_t* h, const char* s) {
+    if (!s) {
+        hash_int(h, -1);
+        return;
+    }
+    size_t n = strlen(s);
+    hash_int(h, (long)n);
+    hash_bytes(h, s, n);
+}
+
+static void hash_node(Compilation* c, uint64_t* h, ASTNode* n) {
+    if (!n) {
+        hash_int(h, -1);
+        return;
+    }
+    hash_int(h, n->type);
+    hash_int(h, n->op);
+    hash_int(h, n->type == NODE_INT || n->type == NODE_BOOL ? n->ival : 0);
+    hash_int(h, n->vtype);
+    hash_str(h, ast_id(n));
+    hash_int(h, n->child_count);
+    if (n->type == NODE_FUNC_CALL) {
+        /* la firma de la función llamada, tal como se conoce ahora */
+        FuncInfo* f = find_function(c->funcs, n->id);
+        if (f) {
+            hash_int(h, f->ret_type);
+            hash_int(h, f->param_count);
+            for (int i = 0; i < f->param_count; i++) hash_int(h, f->param_types[i]);
+        } else {
+            hash_int(h, -2);
+        }
+    }
+    hash_node(c, h, ast_left(n));
+    hash_node(c, h, ast_right(n));
+    for (int i = 0; i < n->child_count; i++)
+        hash_node(c, h, n->children[i]);
+}
+
+static uint64_t hash_unit(Compilation* c, CacheUnit* u) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    hash_str(&h, CACHE_VERSION);
+    hash_int(&h, c->opt_level);
+    hash_int(&h, u->count);
+    for (int i = 0; i < u->count; i++)
+        hash_node(c, &h, u->nodes[i]);
+    return h;
+}
+
+/* ---------- Entradas en disco ----------
+ * <dir>/<hash>.s:
+ *   CACHE_VERSION <hash>
+ *   <etiquetas .L> <etiquetas .LASM> <globales> <bytes de texto>
+ *   una global por línea: nombre y valor inicial
+ *   texto
+ */
+static char* entry_path(Compilation* c, uint64_t hash) {
+    size_t n = strlen(c->cache_dir) + 32;
+    char* p = malloc(n);
+    snprintf(p, n, "%s/%016llx.s", c->cache_dir, (unsigned long long)hash);
+    return p;
+}
+
+static char* read_file(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    char* data = NULL;
+    size_t cap = 0, n = 0, got;
+    do {
+        if (n == cap) {
+            cap = cap ? cap * 2 : 4096;
+            data = realloc(data, cap + 1);
+            if (!data) { perror("realloc"); exit(1); }
+        }
+        got = fread(data + n, 1, cap - n, f);
+        n += got;
+    } while (got > 0);
+    fclose(f);
+    data[n] = '\0';
+    *len = n;
+    return data;
+}
+
+static int cache_load(Compilation* c, CacheUnit* u) {
+    char* path = entry_path(c, u->hash);
+    size_t len;
+    char* data = read_file(path, &len);
+    free(path);
+    if (!data) return 0;
+
+    char tag[32];
+    unsigned long long hash;
+    int labels, asm_labels, nglobals, off = 0;
+    size_t text_len;
+    if (sscanf(data, "%31s %llx %d %d %d %zu%n", tag, &hash, &labels, &asm_labels,
+               &nglobals, &text_len, &off) != 6
+        || strcmp(tag, CACHE_VERSION) != 0 || hash != u->hash || nglobals < 0) {
+        free(data);
+        return 0;
+    }
+    char* p = data + off;
+    char* end = data + len;
+    if (p < end && *p == '\n') p++;
+    GlobalVar* globals = malloc(sizeof(GlobalVar) * (nglobals ? nglobals : 1));
+    for (int i = 0; i < nglobals; i++) {
+        char* nl = memchr(p, '\n', end - p);
+        char* sp = nl ? memchr(p, ' ', nl - p) : NULL;
+        if (!sp) {
+            free(globals);
+            free(data);
+            return 0;
+        }
+        globals[i].name = intern_n(&c->strings, p, sp - p);
+        globals[i].value = (int)strtol(sp + 1, NULL, 10);
+        p = nl + 1;
+    }
+    if ((size_t)(end - p) != text_len) {   // entrada truncada o corrupta
+        free(globals);
+        free(data);
+        return 0;
+    }
+    asmbuf_put(&u->text, p, text_len);
+    u->globals = globals;
+    u->nglobals = nglobals;
+    u->labels = labels;
+    u->asm_labels = asm_labels;
+    free(data);
+    return 1;
+}
+
+/* se escribe en un temporal y se renombra: otra compilación que lea la
+   misma entrada la ve completa o no la ve */
+static void cache_store(Compilation* c, CacheUnit* u) {
+    char* path = entry_path(c, u->hash);
+    size_t n = strlen(c->cache_dir) + 16;
+    char* tmp = malloc(n);
+    snprintf(tmp, n, "%s/.tmpXXXXXX", c->cache_dir);
+    int fd = mkstemp(tmp);
+    FILE* f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!f) {
+        if (fd >= 0) close(fd);
+        free(tmp);
+        free(path);
+        return;
+    }
+    fprintf(f, "%s %016llx\n%d %d %d %zu\n", CACHE_VERSION, (unsigned long long)u->hash,
+            u->labels, u->asm_labels, u->nglobals, u->text.len);
+    for (int i = 0; i < u->nglobals; i++)
+        fprintf(f, "%s %d\n", u->globals[i].name, u->globals[i].value);
+    fwrite(u->text.data, 1, u->text.len, f);
+    if (fclose(f) != 0 || rename(tmp, path) != 0) unlink(tmp);
+    free(tmp);
+    free(path);
+}
+
+/* Las unidades que no están en la caché se generan como con
+   -fparallel-codegen: cada una con su TAC, sus contadores y su buffer, así
+   que pueden repartirse entre codegen_threads hilos */
+typedef struct MissJob {
+    Compilation *c;
+    CacheUnit **units;
+} MissJob;
+
+static void miss_tac(void* arg, int i) {
+    MissJob* job = arg;
+    CacheUnit* u = job->units[i];
+    gen_code_nodes(job->c, &u->gen, &u->code, u->nodes, u->count);
+}
+
+static void miss_asm(void* arg, int i) {
+    MissJob* job = arg;
+    CacheUnit* u = job->units[i];
+    gen_asm_unit(job->c, &u->code, &u->gen, &u->text, &u->globals, &u->nglobals);
+    free(u->code.code);
+    u->labels = u->gen.label_count;
+    u->asm_labels = u->gen.asm_label_count;
+}
+
+void cache_codegen(Compilation* c, ASTNode* prog, AsmBuf* out) {
+    if (mkdir(c->cache_dir, 0777) != 0 && errno != EEXIST)
+        fprintf(c->diag, "%s: %s (se compila sin caché)\n", c->cache_dir, strerror(errno));
+
+    /* una unidad empieza en cada función; lo anterior a la primera va aparte */
+    CacheUnit* units = calloc(prog->child_count + 1, sizeof(CacheUnit));
+    CacheUnit** missed = malloc(sizeof(CacheUnit*) * (prog->child_count + 1));
+    if (!units || !missed) { perror("malloc"); exit(1); }
+    int nunits = 0;
+    for (int i = 0; i < prog->child_count; ++i) {
+        ASTNode* ch = prog->children[i];
+        if (nunits == 0 || (ch && ch->type == NODE_FUNC))
+            units[nunits++].nodes = &prog->children[i];
+        units[nunits - 1].count++;
+    }
+
+    int any_code = 0;       // gen_asm no escribe nada si no hay TAC
+    int nmissed = 0;
+    for (int i = 0; i < nunits; ++i) {
+        CacheUnit* u = &units[i];
+        u->cacheable = u->nodes[0] && u->nodes[0]->type == NODE_FUNC;
+        if (u->cacheable) {
+            u->hash = hash_unit(c, u);
+            if (cache_load(c, u)) {
+                c->cache_hits++;
+                any_code = 1;
+                continue;
+            }
+            c->cache_misses++;
+        }
+        missed[nmissed++] = u;
+    }
+
+    MissJob job = { c, missed };
+    phase_enter(&c->report, PHASE_TAC);
+    parallel_for(nmissed, c->codegen_threads, miss_tac, &job);
+    phase_leave(&c->report);
+    for (int i = 0; i < nmissed; ++i) {
+        phase_count(&c->report, PHASE_TAC, missed[i]->code.count);
+        if (missed[i]->code.count) any_code = 1;
+    }
+    parallel_for(nmissed, c->codegen_threads, miss_asm, &job);
+    for (int i = 0; i < nmissed; ++i)
+        if (missed[i]->cacheable) cache_store(c, missed[i]);
+
+    if (any_code) {
+        int nglobals = 0;
+        for (int i = 0; i < nunits; ++i) nglobals += units[i].nglobals;
+        GlobalVar* globals = malloc(sizeof(GlobalVar) * (nglobals ? nglobals : 1));
+        int k = 0;
+        for (int i = 0; i < nunits; ++i)
+            for (int j = 0; j < units[i].nglobals; ++j)
+                globals[k++] = units[i].globals[j];
+        gen_asm_prologue(out, globals, nglobals);
+        free(globals);
+    }
+    for (int i = 0; i < nunits; ++i) {
+        CacheUnit* u = &units[i];
+        if (any_code)
+            gen_asm_rebase(out, u->text.data, u->text.len, c->gen.label_count, c->gen.asm_label_count);
+        c->gen.label_count += u->labels;
+        c->gen.asm_label_count += u->asm_labels;
+        asmbuf_free(&u->text);
+        free(u->globals);
+    }
+    if (any_code) gen_asm_epilogue(out);
+    free(missed);
+    free(units);
+}
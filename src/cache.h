@@ -0,0 +1,19 @@
+#ifndef CACHE_H
+#define CACHE_H
+#include "compilation.h"
+
+/* ---------- Caché incremental de assembly ----------
+ * Cada función (junto con las declaraciones globales que la siguen, que en
+ * el TAC quedan dentro de su región) se guarda en c->cache_dir bajo un hash
+ * estructural de su AST ya plegado y de las firmas de las funciones que
+ * llama. Si el hash está en la caché se copia su assembly sin generar TAC
+ * ni assembly; si no, se genera y se guarda. El texto se guarda con las
+ * etiquetas numeradas desde 0 y se corre al armar la salida, así el
+ * resultado es el mismo que sin caché.
+ */
+
+/* genera en out el assembly del programa (como gen_code + gen_asm) usando
+   la caché; suma aciertos y fallos en c->cache_hits / c->cache_misses */
+void cache_codegen(Compilation* c, ASTNode* prog, AsmBuf* out);
+
+#endif
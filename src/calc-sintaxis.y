@@ -1,65 +1,110 @@
+%code top {
+#define _GNU_SOURCE     /* struct ucred (server.h) */
+}
+
+%code requires {
+#include "compilation.h"
+/* mismo tipo que define flex con %option reentrant */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+}
+
 %{
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include "ast.h"
 #include "symtable.h"
 #include "codegen.h"
+#include "intern.h"
+#include "functable.h"
+#include "timereport.h"
+#include "driver.h"
+#include "server.h"
+%}
 
-int yylex(void);
-void yyerror(const char *s);
-
-Scope* current_scope = NULL;
-ASTNode* root_ast = NULL;
+%code {
+int yylex(YYSTYPE* lval, yyscan_t scanner);
+void yyerror(yyscan_t scanner, Compilation* ctx, const char *s);
+
+/* Con -ftime-report cada token se mide como fase "lex" dentro del parse */
+static int timed_yylex(YYSTYPE* lval, yyscan_t scanner, Compilation* ctx) {
+    phase_enter(&ctx->report, PHASE_LEX);
+    int tok = yylex(lval, scanner);
+    phase_leave(&ctx->report);
+    if (tok > 0) phase_count(&ctx->report, PHASE_LEX, 1);
+    return tok;
+}
+#define yylex(lval, scanner) timed_yylex(lval, scanner, ctx)
 
-/* --- Estructura para guardar firmas de funciones (no modifica symtable) --- */
-typedef struct FuncInfo {
-    char *name;
-    VarType ret_type;
-    VarType *param_types; /* array */
-    int param_count;
-    struct FuncInfo *next;
-} FuncInfo;
+/* Los chequeos semánticos corren en las acciones; se miden como fase aparte */
+static void sema_begin(Compilation* ctx) {
+    phase_enter(&ctx->report, PHASE_SEMA);
+    phase_count(&ctx->report, PHASE_SEMA, 1);
+}
 
-FuncInfo *func_list = NULL;
-VarType current_function_return_type = TYPE_VOID; /* usado para chequeo de return */
+/* Un error semántico no corta el parseo (así se informan todos), pero la
+   compilación falla y no genera código */
+static void sema_error(Compilation* ctx, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(ctx->diag, "Error: ");
+    vfprintf(ctx->diag, fmt, ap);
+    va_end(ap);
+    ctx->result = 1;
+}
 
 /* Prototipos */
-void register_function_signature(char* name, VarType ret, VarType *param_types, int param_count);
-FuncInfo* find_function(char* name);
-VarType get_expr_type(ASTNode* node, Scope* scope);
+void register_function_signature(Compilation* ctx, const char* name, VarType ret,
+                                 ASTNode** params, int param_count, ASTNode* node);
+void begin_function(Compilation* ctx, VarType ret, const char* name, NodeList* params);
+void end_function(Compilation* ctx, ASTNode* func);
+void check_global_init(Compilation* ctx, ASTNode* decl);
+ASTNode* annotate_expr(Compilation* ctx, ASTNode* node);
 
 /* Helpers */
-void push_scope() {
-    current_scope = create_scope(current_scope);
+static void push_scope(Compilation* ctx) {
+    ctx->current_scope = create_scope(ctx->current_scope);
+}
+static void pop_scope(Compilation* ctx) {
+    Scope* parent = ctx->current_scope->parent;
+    free_scope(ctx->current_scope);
+    ctx->current_scope = parent;
 }
-void pop_scope() {
-    Scope* parent = current_scope->parent;
-    free_scope(current_scope);
-    current_scope = parent;
 }
 
-%}
+/* parser y scanner reentrantes: todo el estado vive en ctx */
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {Compilation* ctx}
 %debug
 
 /* ---------- UNION ---------- */
 %union {
     int ival;
-    char* sval;
+    const char* sval;
     struct ASTNode* node;
+    NodeList list;
     VarType tipo;
 }
 
 /* ---------- TIPOS ---------- */
 %type <node> programa
-%type <node> decl_vars var_decl
+%type <node> var_decl
+%type <list> decl_vars
 %type <node> bloque
-%type <node> sentencias
+%type <list> sentencias
 %type <node> sentencia
-%type <node> decls decl
+%type <list> decls
+%type <node> decl
 %type <node> asignacion retorno while_stmt if_stmt
-%type <node> expr expr_list
-%type <node> lista_param param
+%type <node> expr
+%type <list> expr_list
+%type <list> lista_param
+%type <node> param
 %type <node> method_call
 %type <tipo> tipo
 
@@ -88,145 +133,100 @@ void pop_scope() {
 programa
   : T_PROGRAM T_LBRACE decls T_RBRACE
     {
-      $$ = make_prog_node(
-          $3 ? $3->children : NULL,
-          $3 ? $3->child_count : 0, NULL, 0);
+      $$ = make_prog_node(&ctx->ast, &$3);
       /*print_ast($$, 0); Imprime el árbol */
-      root_ast = $$;
+      ctx->root = $$;
     }
   ;
   
 decls
-    : /* vacío */ { $$ = NULL; }
+    : /* vacío */ { $$ = (NodeList){ NULL, 0, 0 }; }
     | decls decl
       {
-          if ($1 == NULL) {
-              ASTNode* arr[1] = { $2 };
-              $$ = make_block_node(arr, 1);
-          } else {
-              $1->children = realloc($1->children,
-                                     sizeof(ASTNode*) * ($1->child_count + 1));
-              $1->children[$1->child_count++] = $2;
-              $$ = $1;
-          }
+          $$ = $1;
+          /* con -fstream las funciones se compilan acá y no quedan en el AST */
+          if (!ctx->streaming || !compile_toplevel(ctx, $2))
+              nodelist_push(&ctx->ast, &$$, $2);
+          if (ctx->streaming) ctx->stream_mark = ast_mark(&ctx->ast);
       }
     ;
 
 decl
     : var_decl
-    | tipo T_ID T_LPAREN lista_param T_RPAREN bloque
         {
-            /* registrar firma de función */
-            int pcount = $4 ? $4->child_count : 0;
-            VarType *ptypes = NULL;
-            if (pcount > 0) {
-                ptypes = malloc(sizeof(VarType) * pcount);
-                for (int i=0;i<pcount;i++) ptypes[i] = $4->children[i]->vtype;
-            }
-            register_function_signature($2, $1, ptypes, pcount);
-
-            /* crear scope local para la función (su cuerpo ya se construyó en $6) */
-            $$ = make_func_node($1, $2, $4 ? $4->children : NULL,
-                                  $4 ? $4->child_count : 0, $6);
+            $$ = $1;
+            check_global_init(ctx, $$);
+        }
+    | tipo T_ID T_LPAREN lista_param T_RPAREN
+        {
+            /* firma registrada y scope local abierto antes del cuerpo */
+            begin_function(ctx, $1, $2, &$4);
+        }
+      bloque
+        {
+            $$ = make_func_node(&ctx->ast, $1, $2, &$4, $7);
+            end_function(ctx, $$);
         }
-    | T_VOID T_ID T_LPAREN lista_param T_RPAREN bloque
+    | T_VOID T_ID T_LPAREN lista_param T_RPAREN
         {
-            int pcount = $4 ? $4->child_count : 0;
-            VarType *ptypes = NULL;
-            if (pcount > 0) {
-                ptypes = malloc(sizeof(VarType) * pcount);
-                for (int i=0;i<pcount;i++) ptypes[i] = $4->children[i]->vtype;
-            }
-            register_function_signature($2, TYPE_VOID, ptypes, pcount);
-
-            $$ = make_func_node(TYPE_VOID, $2, $4 ? $4->children : NULL,
-                                  $4 ? $4->child_count : 0, $6);
+            begin_function(ctx, TYPE_VOID, $2, &$4);
+        }
+      bloque
+        {
+            $$ = make_func_node(&ctx->ast, TYPE_VOID, $2, &$4, $7);
+            end_function(ctx, $$);
         }
     | tipo T_ID T_LPAREN lista_param T_RPAREN T_EXTERN T_SEMI
         {
-            int pcount = $4 ? $4->child_count : 0;
-            VarType *ptypes = NULL;
-            if (pcount > 0) {
-                ptypes = malloc(sizeof(VarType) * pcount);
-                for (int i=0;i<pcount;i++) ptypes[i] = $4->children[i]->vtype;
-            }
-            register_function_signature($2, $1, ptypes, pcount);
-            $$ = make_extern_func_node($1, $2, $4 ? $4->children : NULL,
-                                         $4 ? $4->child_count : 0);
+            $$ = make_extern_func_node(&ctx->ast, $1, $2, &$4);
+            register_function_signature(ctx, $$->id, $$->vtype, $$->children, $$->child_count, $$);
         }
     | T_VOID T_ID T_LPAREN lista_param T_RPAREN T_EXTERN T_SEMI
         {
-            int pcount = $4 ? $4->child_count : 0;
-            VarType *ptypes = NULL;
-            if (pcount > 0) {
-                ptypes = malloc(sizeof(VarType) * pcount);
-                for (int i=0;i<pcount;i++) ptypes[i] = $4->children[i]->vtype;
-            }
-            register_function_signature($2, TYPE_VOID, ptypes, pcount);
-            $$ = make_extern_func_node(TYPE_VOID, $2, $4 ? $4->children : NULL,
-                                         $4 ? $4->child_count : 0);
+            $$ = make_extern_func_node(&ctx->ast, TYPE_VOID, $2, &$4);
+            register_function_signature(ctx, $$->id, $$->vtype, $$->children, $$->child_count, $$);
         }
     ;
 
 decl_vars
-    : /* vacío */ { $$ = NULL; }
+    : /* vacío */ { $$ = (NodeList){ NULL, 0, 0 }; }
     | decl_vars var_decl
       {
-          if ($1 == NULL) {
-              ASTNode* arr[1] = { $2 };
-              $$ = make_block_node(arr, 1);
-          } else {
-              $1->children = realloc($1->children, sizeof(ASTNode*) * ($1->child_count + 1));
-              $1->children[$1->child_count++] = $2;
-              $$ = $1;
-          }
+          $$ = $1;
+          nodelist_push(&ctx->ast, &$$, $2);
       }
     ;
 
 var_decl
   : tipo T_ID T_ASSIGN expr T_SEMI
     {
-      /* insertar variable en scope actual */
-      if (!insert_symbol(current_scope, $2, $1)) {
-          /* insert_symbol ya imprime error si se repite */
-      } else {
-          /* crear nodo de asignación (inicialización) */
-          $$ = make_assign_node(make_id_node($2), $4);
-      }
+      /* insertar variable en scope actual (falla si se repite) */
+      sema_begin(ctx);
+      if (!insert_symbol(ctx->current_scope, $2, $1))
+          sema_error(ctx, "simbolo '%s' ya declarado\n", $2);
+      phase_leave(&ctx->report);
+      /* crear nodo de declaración (inicialización) */
+      ASTNode* id = make_id_node(&ctx->ast, $2);
+      id->vtype = $1;
+      $$ = make_decl_node(&ctx->ast, id, $4);
     }
   ;
 
 bloque
     : T_LBRACE decl_vars sentencias T_RBRACE
       {
-          int total = ($2 ? $2->child_count : 0) + ($3 ? $3->child_count : 0);
-          ASTNode** all_nodes = malloc(sizeof(ASTNode*) * total);
-          int idx = 0;
-
-          if ($2)
-              for (int i = 0; i < $2->child_count; i++)
-                  all_nodes[idx++] = $2->children[i];
-          if ($3)
-              for (int i = 0; i < $3->child_count; i++)
-                  all_nodes[idx++] = $3->children[i];
-
-          $$ = make_block_node(all_nodes, idx);
+          /* declaraciones seguidas de sentencias, en un solo array */
+          nodelist_append(&ctx->ast, &$2, &$3);
+          $$ = make_block_node(&ctx->ast, &$2);
       }
     ;
     
 sentencias
-    : /* vacío */ { $$ = NULL; }
+    : /* vacío */ { $$ = (NodeList){ NULL, 0, 0 }; }
     | sentencias sentencia
       {
-          if ($1 == NULL) {
-              ASTNode* arr[1] = { $2 };
-              $$ = make_block_node(arr, 1);
-          } else {
-              $1->children = realloc($1->children,
-                                     sizeof(ASTNode*) * ($1->child_count + 1));
-              $1->children[$1->child_count++] = $2;
-              $$ = $1;
-          }
+          $$ = $1;
+          nodelist_push(&ctx->ast, &$$, $2);
       }
     ;
 
@@ -234,28 +234,31 @@ method_call
     : T_ID T_LPAREN expr_list T_RPAREN
       {
           /* chequeo: existe la función y tipos/argc */
-          FuncInfo* f = find_function($1);
+          sema_begin(ctx);
+          FuncInfo* f = find_function(ctx->funcs, $1);
           if (!f) {
-              fprintf(stderr, "Error: función '%s' no declarada\n", $1);
-              $$ = make_func_call_node($1, $3 ? $3->children : NULL, $3 ? $3->child_count : 0);
+              sema_error(ctx, "función '%s' no declarada\n", $1);
+              $$ = make_func_call_node(&ctx->ast, $1, &$3);
+              $$->vtype = TYPE_INT; // valor simbólico para no encadenar errores
           } else {
-              int argc = $3 ? $3->child_count : 0;
+              int argc = $3.count;
               if (argc != f->param_count) {
-                  fprintf(stderr, "Error: llamada a '%s' con %d args, esperaba %d\n",
+                  sema_error(ctx, "llamada a '%s' con %d args, esperaba %d\n",
                           $1, argc, f->param_count);
               } else {
                   /* verificar tipos de cada argumento */
                   for (int i=0;i<argc;i++) {
-                      VarType at = get_expr_type($3->children[i], current_scope);
+                      VarType at = $3.items[i]->vtype;
                       if (at != f->param_types[i]) {
-                          fprintf(stderr, "Error: en llamada a '%s' argumento %d tipo incompatible\n",
+                          sema_error(ctx, "en llamada a '%s' argumento %d tipo incompatible\n",
                                   $1, i+1);
                       }
                   }
               }
-              $$ = make_func_call_node($1, $3 ? $3->children : NULL, $3 ? $3->child_count : 0);
+              $$ = make_func_call_node(&ctx->ast, $1, &$3);
               $$->vtype = f->ret_type;
           }
+          phase_leave(&ctx->report);
       }
     ;
 
@@ -264,7 +267,12 @@ sentencia
     | retorno    { $$ = $1; }
     | while_stmt { $$ = $1; }
     | if_stmt    { $$ = $1; }
-    | method_call T_SEMI    { $$ = make_block_node((ASTNode*[]) { $1 }, 1); }
+    | method_call T_SEMI
+      {
+          NodeList l = { NULL, 0, 0 };
+          nodelist_push(&ctx->ast, &l, $1);
+          $$ = make_block_node(&ctx->ast, &l);
+      }
     | bloque     { $$ = $1; }
     | T_SEMI     { $$ = NULL; }
     ;
@@ -272,101 +280,106 @@ sentencia
 asignacion
     : T_ID T_ASSIGN expr T_SEMI
       {
-          Symbol* s = lookup_symbol(current_scope, $1);
+          sema_begin(ctx);
+          Symbol* s = lookup_symbol(ctx->current_scope, $1);
           if (!s) {
-              fprintf(stderr, "Error: identificador '%s' no declarado\n", $1);
+              sema_error(ctx, "identificador '%s' no declarado\n", $1);
           } else {
               VarType left_t = s->type;
-              VarType right_t = get_expr_type($3, current_scope);
+              VarType right_t = $3->vtype;
               if (left_t != right_t)
-                  fprintf(stderr, "Error: tipo incompatible en asignación a '%s'\n", $1);
+                  sema_error(ctx, "tipo incompatible en asignación a '%s'\n", $1);
           }
-          $$ = make_assign_node(make_id_node($1), $3);
+          phase_leave(&ctx->report);
+          $$ = make_assign_node(&ctx->ast, make_id_node(&ctx->ast, $1), $3);
       }
     ;
 
 retorno
     : T_RETURN expr T_SEMI
       {
-          VarType t = get_expr_type($2, current_scope);
-          if (current_function_return_type == TYPE_VOID) {
-              fprintf(stderr, "Error: return con expresión en función void\n");
-          } else if (t != current_function_return_type) {
-              fprintf(stderr, "Error: tipo en return (%d) no coincide con tipo de función (%d)\n",
-                      t, current_function_return_type);
+          VarType t = $2->vtype;
+          /* en una función void solo puede devolverse otra llamada void */
+          if (ctx->current_return_type == TYPE_VOID) {
+              if (t != TYPE_VOID)
+                  sema_error(ctx, "return con expresión en función void\n");
+          } else if (t != ctx->current_return_type) {
+              sema_error(ctx, "tipo en return (%d) no coincide con tipo de función (%d)\n",
+                      t, ctx->current_return_type);
           }
-          $$ = make_return_node($2);
+          $$ = make_return_node(&ctx->ast, $2);
       }
     | T_RETURN T_SEMI
       {
-          if (current_function_return_type != TYPE_VOID) {
-              fprintf(stderr, "Error: return sin expresión en función que retorna valor\n");
+          if (ctx->current_return_type != TYPE_VOID) {
+              sema_error(ctx, "return sin expresión en función que retorna valor\n");
           }
-          $$ = make_return_node(NULL);
+          $$ = make_return_node(&ctx->ast, NULL);
       }
     ;
 
 if_stmt
     : T_IF T_LPAREN expr T_RPAREN T_THEN bloque %prec T_THEN
       {
-          if (get_expr_type($3, current_scope) != TYPE_BOOL)
-              fprintf(stderr, "Error: condición del 'if' debe ser booleana\n");
-          $$ = make_if_node($3, $6, NULL);
+          if ($3->vtype != TYPE_BOOL)
+              sema_error(ctx, "condición del 'if' debe ser booleana\n");
+          $$ = make_if_node(&ctx->ast, $3, $6, NULL);
       }
     | T_IF T_LPAREN expr T_RPAREN T_THEN bloque T_ELSE bloque
       {
-          if (get_expr_type($3, current_scope) != TYPE_BOOL)
-              fprintf(stderr, "Error: condición del 'if' debe ser booleana\n");
-          $$ = make_if_node($3, $6, $8);
+          if ($3->vtype != TYPE_BOOL)
+              sema_error(ctx, "condición del 'if' debe ser booleana\n");
+          $$ = make_if_node(&ctx->ast, $3, $6, $8);
       }
     ;
 
 while_stmt
     : T_WHILE T_LPAREN expr T_RPAREN bloque
       {
-          if (get_expr_type($3, current_scope) != TYPE_BOOL)
-              fprintf(stderr, "Error: condición del 'while' debe ser booleana\n");
-          $$ = make_while_node($3, $5);
+          if ($3->vtype != TYPE_BOOL)
+              sema_error(ctx, "condición del 'while' debe ser booleana\n");
+          $$ = make_while_node(&ctx->ast, $3, $5);
       }
     ;
 
 expr
-    : T_INT_LITERAL       { $$ = make_int_node($1); $$->vtype = TYPE_INT; }
-    | T_TRUE              { $$ = make_bool_node(1); $$->vtype = TYPE_BOOL; }
-    | T_FALSE             { $$ = make_bool_node(0); $$->vtype = TYPE_BOOL; }
+    : T_INT_LITERAL       { $$ = make_int_node(&ctx->ast, $1); $$->vtype = TYPE_INT; }
+    | T_TRUE              { $$ = make_bool_node(&ctx->ast, 1); $$->vtype = TYPE_BOOL; }
+    | T_FALSE             { $$ = make_bool_node(&ctx->ast, 0); $$->vtype = TYPE_BOOL; }
     | T_ID
       {
-          Symbol* sym = lookup_symbol(current_scope, $1);
+          sema_begin(ctx);
+          Symbol* sym = lookup_symbol(ctx->current_scope, $1);
           if (!sym) {
-              fprintf(stderr, "Error: identificador '%s' no declarado\n", $1);
-              $$ = make_id_node($1);
+              sema_error(ctx, "identificador '%s' no declarado\n", $1);
+              $$ = make_id_node(&ctx->ast, $1);
           } else {
-              $$ = make_id_node($1);
+              $$ = make_id_node(&ctx->ast, $1);
               $$->vtype = sym->type;
           }
+          phase_leave(&ctx->report);
       }
-    | expr T_PLUS expr    { $$ = make_binop_node("+", $1, $3); $$->vtype = TYPE_INT; }
-    | expr T_MINUS expr   { $$ = make_binop_node("-", $1, $3); $$->vtype = TYPE_INT; }
-    | expr T_MUL expr     { $$ = make_binop_node("*", $1, $3); $$->vtype = TYPE_INT; }
-    | expr T_DIV expr     { $$ = make_binop_node("/", $1, $3); $$->vtype = TYPE_INT; }
-    | expr T_MOD expr     { $$ = make_binop_node("%", $1, $3); $$->vtype = TYPE_INT; }
-    | expr T_LT expr      { $$ = make_binop_node("<", $1, $3); $$->vtype = TYPE_BOOL; }
-    | expr T_GT expr      { $$ = make_binop_node(">", $1, $3); $$->vtype = TYPE_BOOL; }
-    | expr T_EQ expr      { $$ = make_binop_node("==", $1, $3); $$->vtype = TYPE_BOOL; }
-    | expr T_AND expr     { $$ = make_binop_node("&&", $1, $3); $$->vtype = TYPE_BOOL; }
-    | expr T_OR expr      { $$ = make_binop_node("||", $1, $3); $$->vtype = TYPE_BOOL; }
-    | T_NOT expr          { $$ = make_unop_node("!", $2); $$->vtype = TYPE_BOOL; }
+    | expr T_PLUS expr    { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_ADD, $1, $3)); }
+    | expr T_MINUS expr   { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_SUB, $1, $3)); }
+    | expr T_MUL expr     { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_MUL, $1, $3)); }
+    | expr T_DIV expr     { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_DIV, $1, $3)); }
+    | expr T_MOD expr     { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_MOD, $1, $3)); }
+    | expr T_LT expr      { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_LT, $1, $3)); }
+    | expr T_GT expr      { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_GT, $1, $3)); }
+    | expr T_EQ expr      { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_EQ, $1, $3)); }
+    | expr T_AND expr     { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_AND, $1, $3)); }
+    | expr T_OR expr      { $$ = annotate_expr(ctx, make_binop_node(&ctx->ast, OP_OR, $1, $3)); }
+    | T_NOT expr          { $$ = annotate_expr(ctx, make_unop_node(&ctx->ast, OP_NOT, $2)); }
     | method_call         { $$ = $1; }
     ;
 
 expr_list
-    : /* vacío */ { $$ = NULL; }
-    | expr { ASTNode* arr[1]={ $1 }; $$ = make_block_node(arr,1); }
-    | expr_list ',' expr
+    : /* vacío */ { $$ = (NodeList){ NULL, 0, 0 }; }
+    | expr { $$ = (NodeList){ NULL, 0, 0 }; nodelist_push(&ctx->ast, &$$, $1); }
+    | expr_list T_COMMA expr
       {
-          $1->children = realloc($1->children, sizeof(ASTNode*)*($1->child_count+1));
-          $1->children[$1->child_count++] = $3;
           $$ = $1;
+          nodelist_push(&ctx->ast, &$$, $3);
       }
     ;
 
@@ -377,13 +390,12 @@ tipo
     ;
 
 lista_param
-    : /* vacío */ { $$ = NULL; }
-    | param { ASTNode* arr[1]={ $1 }; $$ = make_block_node(arr,1); }
-    | lista_param ',' param
+    : /* vacío */ { $$ = (NodeList){ NULL, 0, 0 }; }
+    | param { $$ = (NodeList){ NULL, 0, 0 }; nodelist_push(&ctx->ast, &$$, $1); }
+    | lista_param T_COMMA param
       {
-          $1->children = realloc($1->children,sizeof(ASTNode*)*($1->child_count+1));
-          $1->children[$1->child_count++]=$3;
-          $$=$1;
+          $$ = $1;
+          nodelist_push(&ctx->ast, &$$, $3);
       }
     ;
 
@@ -391,154 +403,136 @@ param
     : tipo T_ID
       {
           /* crear nodo de parámetro */
-          $$ = make_param_node($1,$2);
+          $$ = make_param_node(&ctx->ast, $1,$2);
           $$->vtype = $1;
       }
     ;
 
 %%
 
-/* Registrar firma de función en la lista global */
-void register_function_signature(char* name, VarType ret, VarType *param_types, int param_count) {
-    FuncInfo* existing = find_function(name);
-    if (existing) {
-        fprintf(stderr, "Error: función '%s' ya declarada\n", name);
-        return;
+/* Registrar firma y nodo de la función en el registro de la compilación */
+/* node puede ser NULL si la función todavía no terminó de parsearse
+   (end_function lo completa) */
+void register_function_signature(Compilation* ctx, const char* name, VarType ret,
+                                 ASTNode** params, int param_count, ASTNode* node) {
+    sema_begin(ctx);
+    int pcount = param_count;
+    VarType *ptypes = NULL;
+    if (pcount > 0) {
+        ptypes = malloc(sizeof(VarType) * pcount);
+        for (int i=0;i<pcount;i++) ptypes[i] = params[i]->vtype;
+    }
+    if (!add_function(ctx->funcs, name, ret, ptypes, pcount, node)) {
+        sema_error(ctx, "función '%s' ya declarada\n", name);
+        free(ptypes);
     }
-    FuncInfo* f = malloc(sizeof(FuncInfo));
-    f->name = strdup(name);
-    f->ret_type = ret;
-    f->param_count = param_count;
-    f->param_types = param_types;
-    f->next = func_list;
-    func_list = f;
+    phase_leave(&ctx->report);
 }
 
-/* Buscar función por nombre */
-FuncInfo* find_function(char* name) {
-    for (FuncInfo* f = func_list; f != NULL; f = f->next) {
-        if (strcmp(f->name, name) == 0) return f;
+/* Al ver la cabecera de una función: se registra la firma antes del cuerpo
+   (así puede llamarse recursivamente) y se abre su scope con los parámetros */
+void begin_function(Compilation* ctx, VarType ret, const char* name, NodeList* params) {
+    register_function_signature(ctx, name, ret, params->items, params->count, NULL);
+    push_scope(ctx);
+    sema_begin(ctx);
+    for (int i = 0; i < params->count; i++) {
+        if (!insert_symbol(ctx->current_scope, params->items[i]->id, params->items[i]->vtype))
+            sema_error(ctx, "simbolo '%s' ya declarado\n", params->items[i]->id);
     }
-    return NULL;
+    phase_leave(&ctx->report);
+    ctx->current_return_type = ret;
 }
 
-/* Obtener tipo de una expresión a partir del AST (recursivo) */
-VarType get_expr_type(ASTNode* node, Scope* scope) {
-    if (!node) return TYPE_VOID;
-
-    switch (node->type) {
-        case NODE_INT:
-            return TYPE_INT;
-        case NODE_BOOL:
-            return TYPE_BOOL;
-        case NODE_ID: {
-            Symbol* s = lookup_symbol(scope, node->id);
-            if (!s) {
-                fprintf(stderr, "Error: identificador '%s' no declarado\n", node->id);
-                return TYPE_VOID;
-            }
-            return s->type;
-        }
-        case NODE_BINOP: {
-            VarType l = get_expr_type(node->left, scope);
-            VarType r = get_expr_type(node->right, scope);
+/* Al cerrar el cuerpo: se asocia el nodo a la firma y se cierra el scope */
+void end_function(Compilation* ctx, ASTNode* func) {
+    FuncInfo* f = find_function(ctx->funcs, func->id);
+    if (f && !f->node) f->node = func;
+    pop_scope(ctx);
+    ctx->current_return_type = TYPE_VOID;
+}
+
+/* El valor inicial de una global va a la sección de datos: tiene que ser
+   una constante */
+void check_global_init(Compilation* ctx, ASTNode* decl) {
+    int value;
+    sema_begin(ctx);
+    if (!ast_const_value(decl->right, &value))
+        sema_error(ctx, "el valor inicial de la global '%s' no es constante\n", decl->left->id);
+    phase_leave(&ctx->report);
+}
 
+/* Tipar un operador recién reducido a partir del tipo ya anotado en sus
+   hijos. Las hojas se tipan al reducirse, así que cada nodo se visita una
+   sola vez y cada error se informa una sola vez. */
+ASTNode* annotate_expr(Compilation* ctx, ASTNode* node) {
+    sema_begin(ctx);
+    if (node->type == NODE_BINOP) {
+        VarType l = node->left->vtype;
+        VarType r = node->right->vtype;
+
+        switch (node->op) {
             // Operadores aritméticos → ambos integer
-            if (!strcmp(node->op, "+") || !strcmp(node->op, "-") ||
-                !strcmp(node->op, "*") || !strcmp(node->op, "/") || !strcmp(node->op, "%")) {
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
                 if (l != TYPE_INT || r != TYPE_INT)
-                    fprintf(stderr, "Error: operador '%s' requiere operandos integer\n", node->op);
-                return TYPE_INT;
-            }
+                    sema_error(ctx, "operador '%s' requiere operandos integer\n", op_symbol(node->op));
+                node->vtype = TYPE_INT;
+                break;
 
             // Operadores relacionales → ambos integer, resultado bool
-            if (!strcmp(node->op, "<") || !strcmp(node->op, ">")) {
+            case OP_LT: case OP_GT:
                 if (l != TYPE_INT || r != TYPE_INT)
-                    fprintf(stderr, "Error: comparación '%s' requiere operandos integer\n", node->op);
-                return TYPE_BOOL;
-            }
+                    sema_error(ctx, "comparación '%s' requiere operandos integer\n", op_symbol(node->op));
+                node->vtype = TYPE_BOOL;
+                break;
 
             // Igualdad → operandos del mismo tipo
-            if (!strcmp(node->op, "==")) {
+            case OP_EQ:
                 if (l != r)
-                    fprintf(stderr, "Error: comparación '==' entre tipos distintos\n");
-                return TYPE_BOOL;
-            }
+                    sema_error(ctx, "comparación '==' entre tipos distintos\n");
+                node->vtype = TYPE_BOOL;
+                break;
 
             // Lógicos → operandos booleanos
-            if (!strcmp(node->op, "&&") || !strcmp(node->op, "||")) {
+            case OP_AND: case OP_OR:
                 if (l != TYPE_BOOL || r != TYPE_BOOL)
-                    fprintf(stderr, "Error: operador lógico '%s' requiere operandos bool\n", node->op);
-                return TYPE_BOOL;
-            }
+                    sema_error(ctx, "operador lógico '%s' requiere operandos bool\n", op_symbol(node->op));
+                node->vtype = TYPE_BOOL;
+                break;
 
-            return TYPE_VOID;
+            default:
+                node->vtype = TYPE_VOID;
         }
-        case NODE_UNOP:
-            if (!strcmp(node->op, "!")) {
-                VarType t = get_expr_type(node->left, scope);
+    } else if (node->type == NODE_UNOP) {
+        VarType t = node->left->vtype;
+        switch (node->op) {
+            case OP_NOT:
                 if (t != TYPE_BOOL)
-                    fprintf(stderr, "Error: operador '!' requiere operando bool\n");
-                return TYPE_BOOL;
-            }
-            if (!strcmp(node->op, "-")) {
-                VarType t = get_expr_type(node->left, scope);
+                    sema_error(ctx, "operador '!' requiere operando bool\n");
+                node->vtype = TYPE_BOOL;
+                break;
+            case OP_NEG:
                 if (t != TYPE_INT)
-                    fprintf(stderr, "Error: operador '-' unario requiere integer\n");
-                return TYPE_INT;
-            }
-            return TYPE_VOID;
-        case NODE_FUNC_CALL:
-            return TYPE_INT; // valor simbólico por ahora
-        default:
-            return TYPE_VOID;
+                    sema_error(ctx, "operador '-' unario requiere integer\n");
+                node->vtype = TYPE_INT;
+                break;
+            default:
+                node->vtype = TYPE_VOID;
+        }
     }
+    phase_leave(&ctx->report);
+    return node;
 }
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Error sintáctico: %s\n", s);
+void yyerror(yyscan_t scanner, Compilation* ctx, const char *s) {
+    (void)scanner;
+    fprintf(ctx->diag, "Error sintáctico: %s\n", s);
 }
 
 int main(int argc, char **argv) {
-    extern FILE *yyin;
     /*yydebug = 1; Debug de Bison*/
-    current_scope = create_scope(NULL);  // scope raíz del programa
-
-    if (argc > 1) {
-        yyin = fopen(argv[1], "r");
-        if (!yyin) {
-            perror(argv[1]);
-            return 1;
-        }
-    }
-    int result = yyparse();
-    
-    /* --- Generar código intermedio --- */
-    if (root_ast) {
-    	root_ast = fold_constants(root_ast);
-    	printf("\n=== GENERACIÓN DE CÓDIGO INTERMEDIO ===\n");
-    	TAC* code = gen_code(root_ast);
-    	FILE* fout = fopen("out.s", "w");
-    	gen_asm(code, root_ast, fout);
-	fclose(fout);
-    	/*print_tac(code); Imprime el código intermedio*/
-    	free_tac(code);
-    } else {
-    	printf("No se generó AST raíz.\n");
-    }
-    
-    free_scope(current_scope); // libera el scope raíz
-
-    /* liberar lista de funciones */
-    FuncInfo* f = func_list;
-    while (f) {
-        FuncInfo* tmp = f;
-        f = f->next;
-        free(tmp->name);
-        free(tmp->param_types);
-        free(tmp);
-    }
-
-    return result;
+    /* -fserver[=socket]: el compilador queda residente y atiende a calcc */
+    if (argc == 2 && strncmp(argv[1], "-fserver", 8) == 0 &&
+        (argv[1][8] == '\0' || argv[1][8] == '='))
+        return serve(argv[1][8] ? argv[1] + 9 : NULL);
+    return calc_main(argc, argv, stdin, stdout, stderr);
 }
-
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "cfg.h"
+
+static void* xcalloc(size_t n, size_t size) {
+    void* p = calloc(n ? n : 1, size);
+    if (!p) { perror("calloc"); exit(1); }
+    return p;
+}
+
+static int ends_block(TacOp op) {
+    return op == TAC_GOTO || op == TAC_IF_FALSE_GOTO || op == TAC_RETURN;
+}
+
+/* bloques, en el orden del código, y a qué bloque va cada instrucción */
+static void split_blocks(CFG* g) {
+    const TAC* code = g->code;
+    int n = g->ninstr;
+    g->block_of = xcalloc(n, sizeof(int));
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || code[i].op == TAC_LABEL || ends_block(code[i - 1].op)) count++;
+        g->block_of[i] = count - 1;
+    }
+    g->nblocks = count;
+    g->blocks = xcalloc(count, sizeof(BasicBlock));
+    for (int i = n - 1; i >= 0; i--) g->blocks[g->block_of[i]].first = i;
+    for (int b = 0; b < count; b++) {
+        g->blocks[b].last = b + 1 < count ? g->blocks[b + 1].first : n;
+        g->blocks[b].rpo = g->blocks[b].idom = g->blocks[b].loop_header = -1;
+    }
+}
+
+/* sucesores según la última instrucción, y predecesores */
+static void link_blocks(CFG* g) {
+    const TAC* code = g->code;
+    int lmin = INT_MAX, lmax = INT_MIN;
+    for (int i = 0; i < g->ninstr; i++) {
+        if (code[i].op != TAC_LABEL || code[i].result.kind != OPND_LABEL) continue;
+        if (code[i].result.label < lmin) lmin = code[i].result.label;
+        if (code[i].result.label > lmax) lmax = code[i].result.label;
+    }
+    // etiqueta -> bloque que empieza en ella (+1; 0: no está en la región)
+    int* label_block = xcalloc(lmin <= lmax ? lmax - lmin + 1 : 0, sizeof(int));
+    for (int b = 0; b < g->nblocks; b++) {
+        const TAC* t = &code[g->blocks[b].first];
+        if (t->op == TAC_LABEL && t->result.kind == OPND_LABEL)
+            label_block[t->result.label - lmin] = b + 1;
+    }
+
+    int nedges = 0;
+    for (int b = 0; b < g->nblocks; b++) {
+        BasicBlock* bb = &g->blocks[b];
+        const TAC* last = &code[bb->last - 1];
+        int next = b + 1 < g->nblocks ? b + 1 : -1;
+        int target = -1;
+        if ((last->op == TAC_GOTO || last->op == TAC_IF_FALSE_GOTO) &&
+            last->result.kind == OPND_LABEL &&
+            last->result.label >= lmin && last->result.label <= lmax)
+            target = label_block[last->result.label - lmin] - 1;
+        bb->succ[0] = bb->succ[1] = -1;
+        if (last->op == TAC_GOTO) {
+            bb->succ[0] = target;
+        } else if (last->op == TAC_IF_FALSE_GOTO) {
+            bb->succ[0] = target;
+            if (next != target) bb->succ[1] = next;
+        } else if (last->op != TAC_RETURN) {
+            bb->succ[0] = next;
+        }
+        for (int k = 0; k < 2; k++)
+            if (bb->succ[k] >= 0) { g->blocks[bb->succ[k]].npreds++; nedges++; }
+    }
+    free(label_block);
+
+    g->pred_pool = xcalloc(nedges, sizeof(int));
+    int* p = g->pred_pool;
+    for (int b = 0; b < g->nblocks; b++) {
+        g->blocks[b].preds = p;
+        p += g->blocks[b].npreds;
+        g->blocks[b].npreds = 0;
+    }
+    for (int b = 0; b < g->nblocks; b++) {
+        for (int k = 0; k < 2; k++) {
+            int s = g->blocks[b].succ[k];
+            if (s >= 0) g->blocks[s].preds[g->blocks[s].npreds++] = b;
+        }
+    }
+}
+
+/* postorden inverso desde la entrada, con una pila explícita */
+static void number_blocks(CFG* g) {
+    g->order = xcalloc(g->nblocks, sizeof(int));
+    g->nreachable = 0;
+    if (g->nblocks == 0) return;
+    int* stack = xcalloc(g->nblocks, sizeof(int));
+    int* next_succ = xcalloc(g->nblocks, sizeof(int));
+    char* seen = xcalloc(g->nblocks, 1);
+    int* post = xcalloc(g->nblocks, sizeof(int));
+    int npost = 0, sp = 0;
+    stack[sp++] = 0;
+    seen[0] = 1;
+    while (sp > 0) {
+        int b = stack[sp - 1];
+        if (next_succ[b] < 2) {
+            int s = g->blocks[b].succ[next_succ[b]++];
+            if (s >= 0 && !seen[s]) {
+                seen[s] = 1;
+                stack[sp++] = s;
+            }
+        } else {
+            post[npost++] = b;
+            sp--;
+        }
+    }
+    for (int i = 0; i < npost; i++) {
+        int b = post[npost - 1 - i];
+        g->order[i] = b;
+        g->blocks[b].rpo = i;
+    }
+    g->nreachable = npost;
+    free(stack);
+    free(next_succ);
+    free(seen);
+    free(post);
+}
+
+/* Dominadores inmediatos: el algoritmo iterativo de Cooper, Harvey y
+   Kennedy sobre el postorden inverso (converge en dos o tres pasadas en
+   código estructurado) */
+static void find_dominators(CFG* g) {
+    if (g->nreachable == 0) return;
+    BasicBlock* bl = g->blocks;
+    bl[0].idom = 0;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < g->nreachable; i++) {
+            int b = g->order[i];
+            int idom = -1;
+            for (int k = 0; k < bl[b].npreds; k++) {
+                int p = bl[b].preds[k];
+                if (bl[p].idom < 0) continue;   // inalcanzable o aún sin procesar
+                if (idom < 0) { idom = p; continue; }
+                int x = p, y = idom;
+                while (x != y) {
+                    while (bl[x].rpo > bl[y].rpo) x = bl[x].idom;
+                    while (bl[y].rpo > bl[x].rpo) y = bl[y].idom;
+                }
+                idom = x;
+            }
+            if (idom != bl[b].idom) {
+                bl[b].idom = idom;
+                changed = 1;
+            }
+        }
+    }
+    bl[0].idom = -1;
+}
+
+/* ¿el bloque a domina al bloque b? (todo bloque se domina a sí mismo) */
+static int dominates(const CFG* g, int a, int b) {
+    if (g->blocks[a].rpo < 0 || g->blocks[b].rpo < 0) return 0;
+    while (b >= 0 && g->blocks[b].rpo >= g->blocks[a].rpo) {
+        if (b == a) return 1;
+        b = g->blocks[b].idom;
+    }
+    return 0;
+}
+
+/* Lazos naturales: el cuerpo de un salto hacia atrás p -> h son los bloques
+   desde los que se llega a p sin pasar por h. Las cabeceras se recorren en
+   postorden inverso, así la de un lazo externo se procesa antes que las de
+   sus lazos internos y loop_header queda en el más interno. */
+static void find_loops(CFG* g) {
+    int* mark = xcalloc(g->nblocks, sizeof(int));
+    int* work = xcalloc(g->nblocks, sizeof(int));
+    for (int i = 0; i < g->nreachable; i++) {
+        int h = g->order[i];
+        int nwork = 0, found = 0;
+        for (int k = 0; k < g->blocks[h].npreds; k++) {
+            int p = g->blocks[h].preds[k];
+            if (!dominates(g, h, p)) continue;
+            if (!found) {
+                found = 1;
+                mark[h] = h + 1;
+            }
+            if (mark[p] != h + 1) {
+                mark[p] = h + 1;
+                work[nwork++] = p;
+            }
+        }
+        if (!found) continue;
+        while (nwork > 0) {
+            int b = work[--nwork];
+            for (int k = 0; k < g->blocks[b].npreds; k++) {
+                int p = g->blocks[b].preds[k];
+                if (g->blocks[p].rpo >= 0 && mark[p] != h + 1) {
+                    mark[p] = h + 1;
+                    work[nwork++] = p;
+                }
+            }
+        }
+        for (int b = 0; b < g->nblocks; b++) {
+            if (mark[b] != h + 1) continue;
+            g->blocks[b].loop_depth++;
+            g->blocks[b].loop_header = h;
+        }
+    }
+    free(mark);
+    free(work);
+}
+
+void cfg_build(CFG* g, const TAC* code, int n) {
+    memset(g, 0, sizeof(*g));
+    g->code = code;
+    g->ninstr = n;
+    split_blocks(g);
+    link_blocks(g);
+    number_blocks(g);
+    find_dominators(g);
+    find_loops(g);
+}
+
+void cfg_free(CFG* g) {
+    free(g->blocks);
+    free(g->block_of);
+    free(g->order);
+    free(g->pred_pool);
+    memset(g, 0, sizeof(*g));
+}
@@ -0,0 +1,39 @@
+#ifndef CFG_H
+#define CFG_H
+#include "codegen.h"
+
+/* ---------- Grafo de flujo de control ----------
+ * Bloques básicos de una región de TAC (el cuerpo de una función). Un
+ * bloque empieza en la primera instrucción, en cada LABEL y después de cada
+ * GOTO, IF_FALSE_GOTO o RETURN, así solo su última instrucción salta. Sobre
+ * los bloques alcanzables desde la entrada se calculan el postorden
+ * inverso, los dominadores inmediatos y los lazos naturales: un salto a un
+ * bloque que domina a su origen cierra un lazo con esa cabecera.
+ */
+typedef struct BasicBlock {
+    int first, last;        // instrucciones [first, last) de la región
+    int succ[2];            // -1: ninguno; en un IF_FALSE_GOTO [0] es el salto y [1] la caída
+    int *preds;             // predecesores (apuntan a CFG.pred_pool)
+    int npreds;
+    int rpo;                // posición en postorden inverso (-1: inalcanzable)
+    int idom;               // dominador inmediato (-1: la entrada o inalcanzable)
+    int loop_depth;         // lazos que lo contienen
+    int loop_header;        // cabecera del lazo más interno (-1: fuera de lazos)
+} BasicBlock;
+
+typedef struct CFG {
+    const TAC *code;
+    int ninstr;
+    BasicBlock *blocks;     // en el orden del código; el 0 es la entrada
+    int nblocks;
+    int *block_of;          // instrucción -> bloque
+    int *order;             // bloques alcanzables en postorden inverso
+    int nreachable;
+    int *pred_pool;
+} CFG;
+
+/* arma el grafo de [code, code + n) */
+void cfg_build(CFG* g, const TAC* code, int n);
+void cfg_free(CFG* g);
+
+#endif
@@ -0,0 +1,114 @@
+/* calcc: cliente del servidor de compilación (calc -fserver).
+ *
+ * Acepta la misma línea de comandos que calc y le pasa al servidor el
+ * directorio actual, los argumentos y sus stdin/stdout/stderr; el servidor
+ * escribe directamente en ellos. El código de salida es el de la
+ * compilación. No enlaza nada del compilador, así arranca en lo que tarda
+ * un proceso mínimo.
+ */
+#define _GNU_SOURCE     /* struct ucred */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+
+static int send_request(int fd, int argc, char** argv) {
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        perror("calcc: getcwd");
+        return -1;
+    }
+
+    /* payload: cwd, argv[0], ..., argv[argc-1] */
+    size_t len = strlen(cwd) + 1;
+    for (int i = 0; i < argc; i++) len += strlen(argv[i]) + 1;
+    if (len > SERVER_MAX_PAYLOAD) {
+        fprintf(stderr, "calcc: demasiados argumentos\n");
+        return -1;
+    }
+    char* payload = malloc(len);
+    char* p = payload;
+    size_t n = strlen(cwd) + 1;
+    memcpy(p, cwd, n);
+    p += n;
+    for (int i = 0; i < argc; i++) {
+        n = strlen(argv[i]) + 1;
+        memcpy(p, argv[i], n);
+        p += n;
+    }
+
+    ServerRequest req = { (uint32_t)argc, (uint32_t)len };
+    int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov = { &req, sizeof(req) };
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    int ok = sendmsg(fd, &msg, 0) == (ssize_t)sizeof(req);
+    for (p = payload; ok && p < payload + len; ) {
+        ssize_t w = write(fd, p, payload + len - p);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) ok = 0;
+        else p += w;
+    }
+    free(payload);
+    if (!ok) perror("calcc: envío al servidor");
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    char def[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    const char* path = calc_socket_path(def, sizeof(def), 0);
+    if (!path) {
+        if (errno == ENOENT)
+            fprintf(stderr, "calcc: no hay servidor (iniciarlo con calc -fserver)\n");
+        else
+            fprintf(stderr, "calcc: directorio del socket: %s\n", strerror(errno));
+        return 1;
+    }
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "calcc: ruta de socket demasiado larga: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "calcc: no hay servidor en %s (iniciarlo con calc -fserver)\n", path);
+        return 1;
+    }
+    /* los descriptores y el directorio actual solo se le pasan a un
+       servidor del mismo usuario */
+    if (!calc_peer_is_self(fd)) {
+        fprintf(stderr, "calcc: el servidor en %s es de otro usuario\n", path);
+        return 1;
+    }
+    if (send_request(fd, argc, argv) != 0) return 1;
+
+    int32_t status;
+    ssize_t r;
+    do {
+        r = recv(fd, &status, sizeof(status), MSG_WAITALL);
+    } while (r < 0 && errno == EINTR);
+    if (r != (ssize_t)sizeof(status)) {
+        fprintf(stderr, "calcc: el servidor cerró la conexión\n");
+        return 1;
+    }
+    close(fd);
+    return status;
+}
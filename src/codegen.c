@@ -1,114 +1,184 @@
 #include "codegen.h"
+#include "parallel.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-TAC* make_tac_label(char* label);
-/* contadores para temporales y etiquetas */
-static int temp_count = 0;
-static int label_count = 0;
+static const Operand no_operand = { .kind = OPND_NONE };
 
-static char* new_temp() {
-    char buf[32];
-    sprintf(buf, "t%d", temp_count++);
-    return strdup(buf);
+static Operand opnd_imm(int v)            { Operand o = { .kind = OPND_IMM,   .imm = v };   return o; }
+static Operand opnd_var(const char* name) { Operand o = { .kind = OPND_VAR,   .name = name }; return o; }
+static Operand opnd_func(const char* name){ Operand o = { .kind = OPND_FUNC,  .name = name }; return o; }
+static Operand opnd_label(int id)         { Operand o = { .kind = OPND_LABEL, .label = id }; return o; }
+
+/* los contadores son de la unidad que se genera (temporales: por función) */
+static Operand new_temp(GenCounters* g) {
+    Operand o = { .kind = OPND_TEMP, .temp = g->temp_count++ };
+    return o;
 }
 
-static char* new_label() {
-    char buf[32];
-    sprintf(buf, "L%d", label_count++);
-    return strdup(buf);
+static Operand new_label(GenCounters* g) {
+    return opnd_label(g->label_count++);
 }
 
-/* Crear TAC (duplica strings si no son NULL) */
-static TAC* make_tac(const char* op, const char* a1, const char* a2, const char* res) {
-    TAC* t = malloc(sizeof(TAC));
-    if (!t) { perror("malloc"); exit(1); }
-    t->op = op ? strdup(op) : NULL;
-    t->arg1 = a1 ? strdup(a1) : NULL;
-    t->arg2 = a2 ? strdup(a2) : NULL;
-    t->result = res ? strdup(res) : NULL;
-    t->next = NULL;
-    return t;
+/* Agrega una instrucción al final del buffer (O(1) amortizado) */
+static void emit_tac(TacList* l, TacOp op, Operand a1, Operand a2, Operand res) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 256;
+        l->code = realloc(l->code, sizeof(TAC) * l->cap);
+        if (!l->code) { perror("realloc"); exit(1); }
+    }
+    TAC* t = &l->code[l->count++];
+    t->op = op;
+    t->arg1 = a1;
+    t->arg2 = a2;
+    t->result = res;
 }
 
-/* concatena listas TAC: a seguido de b */
-static TAC* join_tac(TAC* a, TAC* b) {
-    if (!a) return b;
-    TAC* t = a;
-    while (t->next) t = t->next;
-    t->next = b;
-    return a;
+/* escribe un operando en buf en formato legible */
+static const char* operand_str(Operand o, char* buf) {
+    switch (o.kind) {
+        case OPND_IMM:   sprintf(buf, "%d", o.imm); break;
+        case OPND_TEMP:  sprintf(buf, "t%d", o.temp); break;
+        case OPND_LABEL: sprintf(buf, "L%d", o.label); break;
+        case OPND_VAR:
+        case OPND_FUNC:  return o.name;
+        default:         buf[0] = '\0'; break;
+    }
+    return buf;
 }
 
-TAC* tac_get_last(TAC* code) {
-    if (!code) return NULL;
-    TAC* t = code;
-    while (t->next)
-        t = t->next;
-    return t;
+/* imprime TAC en formato legible */
+void print_tac(TacList* code) {
+    char b1[32], b2[32], br[32];
+    for (TAC* t = code->code; t < code->code + code->count; t++) {
+        const char* a1 = operand_str(t->arg1, b1);
+        const char* a2 = operand_str(t->arg2, b2);
+        const char* r = operand_str(t->result, br);
+        switch (t->op) {
+            case TAC_LABEL:
+                printf("%s:\n", r);
+                break;
+            case TAC_GOTO:
+                printf("goto %s\n", r);
+                break;
+            case TAC_IF_FALSE_GOTO:
+                printf("ifFalse %s goto %s\n", a1, r);
+                break;
+            case TAC_CALL:
+                printf("%s = call %s, %s\n", r, a1, t->arg2.kind != OPND_NONE ? a2 : "0");
+                break;
+            case TAC_RETURN:
+                if (t->arg1.kind != OPND_NONE)
+                    printf("return %s\n", a1);
+                else
+                    printf("return\n");
+                break;
+            case TAC_PARAM:
+                printf("param %s\n", a1);
+                break;
+            case TAC_GLOBAL:
+                printf("global %s = %s\n", r, a1);
+                break;
+            case TAC_COPY:
+            case TAC_ASSIGN:
+                printf("%s = %s\n", r, a1);
+                break;
+            case TAC_NOT:
+            case TAC_NEG:
+                printf("%s = %s %s\n", r, op_symbol((OpKind)t->op), a1);
+                break;
+            default:
+                printf("%s = %s %s %s\n", r, a1, op_symbol((OpKind)t->op), a2);
+                break;
+        }
+    }
+}
+
+/* libera lista TAC */
+void free_tac(TacList* code) {
+    if (!code) return;
+    free(code->code);
+    free(code);
 }
 
-/* devuelve el último nodo de la lista o NULL */
-static TAC* tac_last(TAC* t) {
-    if (!t) return NULL;
-    while (t->next) t = t->next;
+/* ¿la evaluación de la expresión hace alguna llamada? */
+static int has_call(ASTNode* node) {
+    if (!node) return 0;
+    if (node->type == NODE_FUNC_CALL) return 1;
+    return has_call(ast_left(node)) || has_call(ast_right(node));
+}
+
+/* Las hojas no pasan por un temporal: un literal o una variable se usan
+   directo como operando. Una variable se lee recién en la instrucción que la
+   usa, así que si antes se evalúa una llamada (que puede cambiar una
+   global) se copia a un temporal donde aparece, como antes. */
+static Operand pin_leaf(GenCounters* g, TacList* out, Operand o) {
+    if (o.kind != OPND_VAR) return o;
+    Operand t = new_temp(g);
+    emit_tac(out, TAC_COPY, o, no_operand, t);
     return t;
 }
 
-/* imprime TAC en formato legible */
-void print_tac(TAC* code) {
-    for (TAC* t = code; t; t = t->next) {
-        if (!t->op) continue;
-        if (strcmp(t->op, "LABEL") == 0) {
-            printf("%s:\n", t->result);
-        } else if (strcmp(t->op, "GOTO") == 0) {
-            printf("goto %s\n", t->result);
-        } else if (strcmp(t->op, "IF_FALSE_GOTO") == 0) {
-            printf("ifFalse %s goto %s\n", t->arg1 ? t->arg1 : "", t->result ? t->result : "");
-        } else if (strcmp(t->op, "CALL") == 0) {
-            printf("%s = call %s, %s\n", t->result ? t->result : "", t->arg1 ? t->arg1 : "", t->arg2 ? t->arg2 : "0");
-        } else if (strcmp(t->op, "RETURN") == 0) {
-            if (t->arg1)
-                printf("return %s\n", t->arg1);
-            else
-                printf("return\n");
-        } else if (strcmp(t->op, "PARAM") == 0) {
-            printf("param %s\n", t->arg1 ? t->arg1 : "");
-        } else if (strcmp(t->op, "ASSIGN") == 0) {
-            printf("%s = %s\n", t->result ? t->result : "", t->arg1 ? t->arg1 : "");
+static Operand gen_code_internal(Compilation* c, GenCounters* g, TacList* out, ASTNode* node);
+
+/* Condición de un if o un while: salta a label si la condición vale sense
+   y si no sigue de largo. && y || se vuelven un árbol de saltos (cada
+   comparación salta directo) cuando el operando derecho no hace llamadas;
+   con una llamada se evalúan los dos, como en una expresión. Saltar si es
+   verdadera es IF_FALSE sobre el NOT, que el generador de assembly junta
+   en un solo salto. */
+static void gen_branch(Compilation* c, GenCounters* g, TacList* out, ASTNode* node,
+                       Operand label, int sense) {
+    if (node->type == NODE_UNOP && node->op == OP_NOT) {
+        gen_branch(c, g, out, node->left, label, !sense);
+        return;
+    }
+    if (node->type == NODE_BINOP && (node->op == OP_AND || node->op == OP_OR)
+        && !has_call(node->right)) {
+        // a && b es falso si a lo es; a || b es verdadero si a lo es
+        int short_sense = node->op == OP_OR;
+        if (sense == short_sense) {
+            gen_branch(c, g, out, node->left, label, sense);
+            gen_branch(c, g, out, node->right, label, sense);
         } else {
-            if (strcmp(t->op, "=") == 0 && t->arg1 && !t->arg2) {
-                printf("%s = %s\n", t->result, t->arg1);
-            } else if (t->result && t->arg2) {
-                printf("%s = %s %s %s\n", t->result, t->arg1 ? t->arg1 : "", t->op ? t->op : "", t->arg2 ? t->arg2 : "");
-            } else if (t->result && t->arg1 && !t->arg2) {
-                printf("%s = %s %s\n", t->result, t->op ? t->op : "", t->arg1);
-            } else {
-                printf("%s %s %s %s\n", t->op ? t->op : "", t->arg1 ? t->arg1 : "", t->arg2 ? t->arg2 : "", t->result ? t->result : "");
-            }
+            Operand skip = new_label(g);
+            gen_branch(c, g, out, node->left, skip, short_sense);
+            gen_branch(c, g, out, node->right, label, sense);
+            emit_tac(out, TAC_LABEL, no_operand, no_operand, skip);
         }
+        return;
     }
+    Operand r = gen_code_internal(c, g, out, node);
+    if (sense) {
+        Operand t = new_temp(g);
+        emit_tac(out, TAC_NOT, r, no_operand, t);
+        r = t;
+    }
+    emit_tac(out, TAC_IF_FALSE_GOTO, r, no_operand, label);
 }
 
-/* libera lista TAC */
-void free_tac(TAC* code) {
-    while (code) {
-        TAC* tmp = code;
-        code = code->next;
-        if (tmp->op) free(tmp->op);
-        if (tmp->arg1) free(tmp->arg1);
-        if (tmp->arg2) free(tmp->arg2);
-        if (tmp->result) free(tmp->result);
-        free(tmp);
+/* Una declaración de primer nivel es una global: no genera código, solo
+   TAC_GLOBAL con su valor inicial (el análisis semántico ya exigió que sea
+   constante) para la sección de datos */
+static void gen_toplevel(Compilation* c, GenCounters* g, TacList* out, ASTNode* node) {
+    if (node && node->type == NODE_DECL) {
+        int value = 0;
+        ast_const_value(node->right, &value);
+        emit_tac(out, TAC_GLOBAL, opnd_imm(value), no_operand, opnd_var(node->left->id));
+        return;
     }
+    gen_code_internal(c, g, out, node);
 }
 
-/* generación de expresiones (devuelve lista TAC cuyo último tiene campo result con la "location") */
-static TAC* gen_code_internal(ASTNode* node) {
+/* generación de código: agrega las instrucciones del nodo al final de out y,
+   para expresiones, devuelve la "location" con el resultado (un temporal,
+   o el literal o la variable misma si es una hoja);
+   OPND_NONE si el nodo no produce valor */
+static Operand gen_code_internal(Compilation* c, GenCounters* g, TacList* out, ASTNode* node) {
     if (!node) {
         /*printf("gen_code_internal: node=NULL\n");*/
-        return NULL;
+        return no_operand;
     }
     /*printf("GEN debug: node type=%d, child_count=%d, id=%s\n",
            node->type, node->child_count, node->id?node->id:"(no id)");
@@ -127,123 +197,96 @@ static TAC* gen_code_internal(ASTNode* node) {
     
     switch (node->type) {
 
-        case NODE_INT: {
-            char tmpbuf[32];
-            sprintf(tmpbuf, "%d", node->ival);
-            char* t = new_temp();
-            return make_tac("=", tmpbuf, NULL, t);
-        }
+        case NODE_INT:
+            return opnd_imm(node->ival);
 
-        case NODE_BOOL: {
-            char tmpbuf[8];
-            sprintf(tmpbuf, "%d", node->ival ? 1 : 0);
-            char* t = new_temp();
-            return make_tac("=", tmpbuf, NULL, t);
-        }
+        case NODE_BOOL:
+            return opnd_imm(node->ival ? 1 : 0);
 
-        case NODE_ID: {
-            char* t = new_temp();
-            return make_tac("=", node->id, NULL, t);
-        }
+        case NODE_ID:
+            return opnd_var(node->id);
 
         case NODE_BINOP: {
-            TAC* c1 = gen_code_internal(node->left);
-            TAC* c2 = gen_code_internal(node->right);
-            char* r1 = tac_last(c1) ? tac_last(c1)->result : NULL;
-            char* r2 = tac_last(c2) ? tac_last(c2)->result : NULL;
-            char* tres = new_temp();
-            TAC* op = make_tac(node->op, r1 ? r1 : "", r2 ? r2 : "", tres);
-            return join_tac(join_tac(c1, c2), op);
+            Operand r1 = gen_code_internal(c, g, out, node->left);
+            if (r1.kind == OPND_VAR && has_call(node->right))
+                r1 = pin_leaf(g, out, r1);
+            Operand r2 = gen_code_internal(c, g, out, node->right);
+            Operand tres = new_temp(g);
+            emit_tac(out, (TacOp)node->op, r1, r2, tres);
+            return tres;
         }
 
         case NODE_UNOP: {
-            TAC* c = gen_code_internal(node->left);
-            char* r = tac_last(c) ? tac_last(c)->result : NULL;
-            char* tres = new_temp();
-            if (node->op && strcmp(node->op, "!") == 0) {
-                return join_tac(c, make_tac("!", r ? r : "", NULL, tres));
-            } else if (node->op && strcmp(node->op, "-") == 0) {
-                return join_tac(c, make_tac("NEG", r ? r : "", NULL, tres));
-            } else {
-                return c;
+            Operand r = gen_code_internal(c, g, out, node->left);
+            switch (node->op) {
+                case OP_NOT:
+                case OP_NEG: {
+                    Operand tres = new_temp(g);
+                    emit_tac(out, (TacOp)node->op, r, no_operand, tres);
+                    return tres;
+                }
+                default:
+                    return r;
             }
         }
 
-        case NODE_ASSIGN: {
-            TAC* rhs = gen_code_internal(node->right);
-            char* rval = tac_last(rhs) ? tac_last(rhs)->result : NULL;
-            TAC* asg = make_tac("ASSIGN", rval ? rval : "", NULL, node->left->id);
-            return join_tac(rhs, asg);
+        case NODE_ASSIGN:
+        case NODE_DECL: {
+            Operand rval = gen_code_internal(c, g, out, node->right);
+            emit_tac(out, TAC_ASSIGN, rval, no_operand, opnd_var(node->left->id));
+            return no_operand;
         }
 
         case NODE_RETURN: {
             if (node->left) {
-                TAC* expr = gen_code_internal(node->left);
-                char* r = tac_last(expr) ? tac_last(expr)->result : NULL;
-                TAC* ret = make_tac("RETURN", r ? r : "", NULL, NULL);
-                return join_tac(expr, ret);
+                Operand r = gen_code_internal(c, g, out, node->left);
+                emit_tac(out, TAC_RETURN, r, no_operand, no_operand);
             } else {
-                return make_tac("RETURN", NULL, NULL, NULL);
+                emit_tac(out, TAC_RETURN, no_operand, no_operand, no_operand);
             }
+            return no_operand;
         }
         
         case NODE_IF: {
-            TAC* cond = gen_code_internal(node->left);
-            char* label_else = new_label();
-            char* label_end = new_label();
-            //TAC* code = join_tac(cond, make_tac("ifFalse", cond->result, label_else, NULL));
-            TAC* last_cond = tac_get_last(cond);
-            TAC* code = join_tac(cond, make_tac("ifFalse", last_cond->result, label_else, NULL));
+            Operand label_else = new_label(g);
+            Operand label_end = new_label(g);
+            gen_branch(c, g, out, node->left, label_else, 0);
 
             // THEN
-            TAC* then_code = gen_code_internal(node->children[0]);
-            code = join_tac(code, then_code);
-            code = join_tac(code, make_tac("goto", label_end, NULL, NULL));
+            gen_code_internal(c, g, out, node->children[0]);
+            emit_tac(out, TAC_GOTO, no_operand, no_operand, label_end);
 
             // ELSE (si existe)
-            code = join_tac(code, make_tac_label(label_else));
+            emit_tac(out, TAC_LABEL, no_operand, no_operand, label_else);
             if (node->child_count > 1 && node->children[1])
-                code = join_tac(code, gen_code_internal(node->children[1]));
+                gen_code_internal(c, g, out, node->children[1]);
 
-            code = join_tac(code, make_tac_label(label_end));
-            return code;
+            emit_tac(out, TAC_LABEL, no_operand, no_operand, label_end);
+            return no_operand;
         }
 
         case NODE_WHILE: {
-            char* Lstart = new_label();
-            char* Lend = new_label();
-            TAC* label_start = make_tac("LABEL", NULL, NULL, Lstart);
-
-            TAC* cond = gen_code_internal(node->left);
-            char* cond_res = tac_last(cond) ? tac_last(cond)->result : NULL;
-            TAC* iffalse = make_tac("IF_FALSE_GOTO", cond_res ? cond_res : "", NULL, Lend);
-
-            TAC* body = gen_code_internal(node->right);
-            TAC* goto_start = make_tac("GOTO", NULL, NULL, Lstart);
-            TAC* label_end = make_tac("LABEL", NULL, NULL, Lend);
-
-            TAC* seq = label_start;
-            seq = join_tac(seq, cond);
-            seq = join_tac(seq, iffalse);
-            seq = join_tac(seq, body);
-            seq = join_tac(seq, goto_start);
-            seq = join_tac(seq, label_end);
-
-            return seq;
+            Operand Lstart = new_label(g);
+            Operand Lend = new_label(g);
+            emit_tac(out, TAC_LABEL, no_operand, no_operand, Lstart);
+
+            gen_branch(c, g, out, node->left, Lend, 0);
+
+            gen_code_internal(c, g, out, node->right);
+            emit_tac(out, TAC_GOTO, no_operand, no_operand, Lstart);
+            emit_tac(out, TAC_LABEL, no_operand, no_operand, Lend);
+            return no_operand;
         }
 
         case NODE_BLOCK: {
-            TAC* total = NULL;
-            for (int i = 0; i < node->child_count; ++i) {
-                total = join_tac(total, gen_code_internal(node->children[i]));
-            }
-            return total;
+            for (int i = 0; i < node->child_count; ++i)
+                gen_code_internal(c, g, out, node->children[i]);
+            return no_operand;
         }
 
         case NODE_FUNC: {
-            char labelbuf[64];
-            sprintf(labelbuf, "%s", node->id);
-            TAC* seq = make_tac("LABEL", NULL, NULL, labelbuf);
+            emit_tac(out, TAC_LABEL, no_operand, no_operand, opnd_func(node->id));
+            g->temp_count = 0;  // los temporales se numeran por función
 
             /* buscar cuerpo: primer BLOCK entre children (si existe) */
             for (int i = 0; i < node->child_count; ++i) {
@@ -251,42 +294,153 @@ static TAC* gen_code_internal(ASTNode* node) {
                 if (!ch) continue;
                 /* omitir params/otros; procesar todos los nodos que no sean PARAM */
                 if (ch->type == NODE_PARAM) continue;
-                TAC* stm = gen_code_internal(ch);
-                if (stm) seq = join_tac(seq, stm);
+                gen_code_internal(c, g, out, ch);
             }
-
-            return seq;
+            return no_operand;
         }
         
-        case NODE_EXTERN_FUNC: {
-            char labelbuf[64];
-            sprintf(labelbuf, "%s", node->id);
-            return make_tac("LABEL", NULL, NULL, labelbuf);
+        case NODE_EXTERN_FUNC:
+            /* la define otra unidad (p.ej. el runtime): no genera código */
+            return no_operand;
+
+        case NODE_FUNC_CALL: {
+            /* primero se evalúan todos los argumentos y recién después se
+               emiten los PARAM, así quedan contiguos e inmediatamente antes
+               del CALL aunque haya llamadas anidadas */
+            int n = node->child_count;
+            Operand* args = n ? malloc(sizeof(Operand) * n) : NULL;
+            // calls_after[i]: algún argumento posterior a i hace una llamada
+            char* calls_after = n ? calloc(n, 1) : NULL;
+            for (int i = n - 2; i >= 0; --i)
+                calls_after[i] = calls_after[i + 1] || has_call(node->children[i + 1]);
+            for (int i = 0; i < n; ++i) {
+                args[i] = gen_code_internal(c, g, out, node->children[i]);
+                if (calls_after[i]) args[i] = pin_leaf(g, out, args[i]);
+            }
+            free(calls_after);
+            for (int i = 0; i < n; ++i)
+                emit_tac(out, TAC_PARAM, args[i], no_operand, no_operand);
+            free(args);
+            Operand tres = new_temp(g);
+            emit_tac(out, TAC_CALL, opnd_func(node->id), opnd_imm(n), tres);
+            return tres;
         }
 
         case NODE_PARAM:
-            return NULL;
+            return no_operand;
 
         case NODE_PROG: {
-            TAC* total = NULL;
-            for (int i = 0; i < node->child_count; ++i) {
-                total = join_tac(total, gen_code_internal(node->children[i]));
-            }
-            return total;
+            for (int i = 0; i < node->child_count; ++i)
+                gen_toplevel(c, g, out, node->children[i]);
+            return no_operand;
         }
 
         default:
-            fprintf(stderr, "Nodo sin generación implementada: %d\n", node->type);
-            return NULL;
+            fprintf(c->diag, "Nodo sin generación implementada: %d\n", node->type);
+            return no_operand;
     }
 }
 
-/* wrapper para la API del header: usamos el mismo nombre gen_code */
-TAC* gen_code(ASTNode* node) {
-    return gen_code_internal(node);
+/* genera nodos consecutivos con los contadores g (p.ej. una unidad que
+   empieza numerando desde 0) */
+void gen_code_nodes(Compilation* c, GenCounters* g, TacList* out, ASTNode** nodes, int count) {
+    for (int k = 0; k < count; ++k)
+        gen_toplevel(c, g, out, nodes[k]);
 }
 
-TAC* make_tac_label(char* label) {
-    return make_tac("LABEL", NULL, NULL, label);
+/* ---------- Generación en paralelo ----------
+ * Los hijos de NODE_PROG se reparten en tramos consecutivos que empiezan
+ * siempre en una función (las declaraciones globales que siguen a una
+ * función quedan con ella, igual que su TAC en serie). Cada tramo tiene su
+ * propia lista y sus propios contadores; las etiquetas se numeran desde 0
+ * en cada tramo y al concatenar se corren por la cantidad usada en los
+ * anteriores, así el resultado es el mismo TAC que en serie.
+ */
+typedef struct GenUnit {
+    ASTNode **nodes;        // tramo de hijos consecutivos de NODE_PROG
+    int count;
+    TacList code;
+    GenCounters gen;
+} GenUnit;
+
+typedef struct GenJob {
+    Compilation *c;
+    GenUnit *units;
+} GenJob;
+
+static void gen_unit(void* arg, int i) {
+    GenJob* job = arg;
+    GenUnit* u = &job->units[i];
+    gen_code_nodes(job->c, &u->gen, &u->code, u->nodes, u->count);
 }
 
+static void shift_label(Operand* o, int base) {
+    if (o->kind == OPND_LABEL) o->label += base;
+}
+
+static void gen_code_parallel(Compilation* c, TacList* out, ASTNode* prog) {
+    int nfuncs = 0;
+    for (int i = 0; i < prog->child_count; ++i)
+        if (prog->children[i] && prog->children[i]->type == NODE_FUNC) nfuncs++;
+    int target = c->codegen_threads * PARALLEL_CHUNKS_PER_THREAD;
+    int per_unit = (nfuncs + target - 1) / target;
+    if (per_unit < 1) per_unit = 1;
+
+    /* un tramo nuevo empieza en una función cuando el actual ya tiene
+       per_unit; lo anterior a la primera función va en el primero */
+    GenUnit* units = calloc(target + 1, sizeof(GenUnit));
+    if (!units) { perror("calloc"); exit(1); }
+    int nunits = 0, funcs_in_unit = 0;
+    for (int i = 0; i < prog->child_count; ++i) {
+        ASTNode* ch = prog->children[i];
+        int is_func = ch && ch->type == NODE_FUNC;
+        if (nunits == 0 || (is_func && funcs_in_unit == per_unit)) {
+            units[nunits++].nodes = &prog->children[i];
+            funcs_in_unit = 0;
+        }
+        units[nunits - 1].count++;
+        funcs_in_unit += is_func;
+    }
+    /* la primera unidad sigue la numeración que ya tenía la compilación */
+    units[0].gen = c->gen;
+
+    GenJob job = { c, units };
+    parallel_for(nunits, c->codegen_threads, gen_unit, &job);
+
+    int total = 0;
+    for (int i = 0; i < nunits; ++i) total += units[i].code.count;
+    out->code = malloc(sizeof(TAC) * (total ? total : 1));
+    if (!out->code) { perror("malloc"); exit(1); }
+    out->cap = total;
+
+    int base = 0;   // etiquetas usadas por las unidades anteriores
+    for (int i = 0; i < nunits; ++i) {
+        GenUnit* u = &units[i];
+        TAC* dst = out->code + out->count;
+        memcpy(dst, u->code.code, sizeof(TAC) * u->code.count);
+        out->count += u->code.count;
+        if (base) {
+            for (TAC* t = dst; t < dst + u->code.count; t++) {
+                shift_label(&t->arg1, base);
+                shift_label(&t->arg2, base);
+                shift_label(&t->result, base);
+            }
+        }
+        base += u->gen.label_count;
+        free(u->code.code);
+    }
+    c->gen.temp_count = units[nunits - 1].gen.temp_count;
+    c->gen.label_count = base;
+    free(units);
+}
+
+/* wrapper para la API del header: usamos el mismo nombre gen_code */
+TacList* gen_code(Compilation* c, ASTNode* node) {
+    TacList* out = calloc(1, sizeof(TacList));
+    if (!out) { perror("calloc"); exit(1); }
+    if (c->codegen_threads > 1 && node && node->type == NODE_PROG && node->child_count > 0)
+        gen_code_parallel(c, out, node);
+    else
+        gen_toplevel(c, &c->gen, out, node);
+    return out;
+}
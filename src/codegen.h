@@ -2,20 +2,99 @@
 #define CODEGEN_H
 #include <stdio.h>
 #include "ast.h"
+#include "compilation.h"
+#include "asmbuf.h"
+
+/* ---------- Tipos de instrucción TAC ----------
+ * Los operadores de expresión conservan el valor de OpKind, así un nodo
+ * BINOP/UNOP se traduce con un simple cast.
+ */
+typedef enum {
+    TAC_ADD = OP_ADD, TAC_SUB = OP_SUB, TAC_MUL = OP_MUL,
+    TAC_DIV = OP_DIV, TAC_MOD = OP_MOD,
+    TAC_LT = OP_LT, TAC_GT = OP_GT, TAC_EQ = OP_EQ,
+    TAC_AND = OP_AND, TAC_OR = OP_OR,
+    TAC_NOT = OP_NOT, TAC_NEG = OP_NEG,
+    TAC_COPY = OP_COUNT,    // t = x (temporal desde literal o variable)
+    TAC_ASSIGN,             // var = x
+    TAC_LABEL,
+    TAC_GOTO,
+    TAC_IF_FALSE_GOTO,
+    TAC_PARAM,
+    TAC_CALL,
+    TAC_RETURN,
+    TAC_GLOBAL              // global var = imm (declaración de primer nivel)
+} TacOp;
+
+/* ---------- Operandos TAC ----------
+ * Cada operando sabe qué es; el generador de assembly no vuelve a parsear
+ * cadenas. Los temporales se numeran desde 0 en cada función, así sirven
+ * de índice a un array denso de slots. Los nombres están internados.
+ */
+typedef enum {
+    OPND_NONE,
+    OPND_IMM,       // literal entero
+    OPND_TEMP,      // temporal tN
+    OPND_VAR,       // variable de usuario (local, parámetro o global)
+    OPND_LABEL,     // etiqueta interna LN
+    OPND_FUNC       // nombre de función (etiqueta de función, destino de CALL)
+} OperandKind;
+
+typedef struct Operand {
+    OperandKind kind;
+    union {
+        int imm;
+        int temp;
+        int label;
+        const char *name;   // VAR y FUNC
+    };
+} Operand;
 
 /* ---------- Estructura del Código Intermedio (TAC) ---------- */
 typedef struct TAC {
-    char *op;           // operador o instrucción (ADD, SUB, IFGOTO, CALL, etc.)
-    char *arg1;         // primer operando
-    char *arg2;         // segundo operando
-    char *result;       // resultado (temporal o variable)
-    struct TAC *next;   // siguiente instrucción
+    TacOp op;           // operador o instrucción (ADD, SUB, IFGOTO, CALL, etc.)
+    Operand arg1;       // primer operando
+    Operand arg2;       // segundo operando
+    Operand result;     // resultado (temporal, variable o etiqueta)
 } TAC;
 
+/* Secuencia de instrucciones en un buffer contiguo (crece al doble) */
+typedef struct TacList {
+    TAC *code;
+    int count;
+    int cap;
+} TacList;
+
+/* Una global de la sección de datos y su valor inicial */
+typedef struct GlobalVar {
+    const char *name;   // internado
+    int value;
+} GlobalVar;
+
 /* ---------- Funciones ---------- */
-TAC* gen_code(ASTNode* node);
-void print_tac(TAC* code);
-void free_tac(TAC* code);
-void gen_asm(TAC* code, ASTNode* ast_root, FILE* out);
+TacList* gen_code(Compilation* c, ASTNode* node);
+void gen_code_nodes(Compilation* c, GenCounters* g, TacList* out, ASTNode** nodes, int count);
+void print_tac(TacList* code);
+void free_tac(TacList* code);
+void gen_asm(Compilation* c, TacList* code, AsmBuf* out);
+
+/* Modo streaming: encabezado, después el código de cada función apenas se
+   genera su TAC (recordando las globales que usa) y al final la sección de
+   datos. gen_asm_discard libera el estado si la compilación se aborta. */
+void gen_asm_begin(Compilation* c, AsmBuf* out);
+void gen_asm_func(Compilation* c, TacList* code, AsmBuf* out);
+void gen_asm_end(Compilation* c, AsmBuf* out);
+void gen_asm_discard(Compilation* c);
+
+/* Caché incremental: gen_asm por partes. gen_asm_unit emite las funciones
+   de code con los contadores g (desde 0) y devuelve en *globals (liberar
+   con free) las globales que declara, en orden. gen_asm_rebase copia un
+   texto así generado corriendo sus etiquetas .L y .LASM. El prólogo escribe
+   encabezado y datos y el epílogo el cierre. */
+void gen_asm_unit(Compilation* c, TacList* code, GenCounters* g, AsmBuf* out,
+                  GlobalVar** globals, int* nglobals);
+void gen_asm_rebase(AsmBuf* out, const char* text, size_t len, int label_base, int asm_label_base);
+void gen_asm_prologue(AsmBuf* out, const GlobalVar* globals, int nglobals);
+void gen_asm_epilogue(AsmBuf* out);
 #endif
 
@@ -1,499 +1,997 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <stdarg.h>
+#include <limits.h>
 #include "codegen.h"
 #include "ast.h"
+#include "intern.h"
+#include "asmbuf.h"
+#include "parallel.h"
+#include "cfg.h"
+#include "regalloc.h"
+#include "ssa.h"
+
+/* Name map: interned name -> int, open addressing keyed by the pointer */
+typedef struct NameMap {
+    const char **keys;
+    int *vals;
+    int cap;    // power of 2
+    int count;
+} NameMap;
+
+static void namemap_init(NameMap* m, int cap) {
+    m->cap = 16;
+    while (m->cap < cap * 2) m->cap <<= 1;
+    m->count = 0;
+    m->keys = calloc(m->cap, sizeof(const char*));
+    m->vals = malloc(sizeof(int) * m->cap);
+    if (!m->keys || !m->vals) { perror("malloc"); exit(1); }
+}
 
-/* Simple string set / list utilities */
-typedef struct StrNode {
-    char *s;
-    struct StrNode *next;
-} StrNode;
-
-static int strnode_contains(StrNode* h, const char* s) {
-    for (; h; h = h->next) if (strcmp(h->s, s) == 0) return 1;
-    return 0;
+static int namemap_slot(const NameMap* m, const char* key) {
+    unsigned mask = m->cap - 1;
+    unsigned i = intern_ptr_hash(key) & mask;
+    while (m->keys[i] && m->keys[i] != key) i = (i + 1) & mask;
+    return i;
 }
 
-static StrNode* strnode_add(StrNode* h, const char* s) {
-    if (!s) return h;
-    if (strnode_contains(h, s)) return h;
-    StrNode* n = malloc(sizeof(StrNode));
-    n->s = strdup(s);
-    n->next = h;
-    return n;
+static int* namemap_find(const NameMap* m, const char* key) {
+    if (!m->keys) return NULL;
+    int i = namemap_slot(m, key);
+    return m->keys[i] ? &m->vals[i] : NULL;
 }
 
-static void strnode_free(StrNode* h) {
-    while (h) {
-        StrNode* t = h; h = h->next;
-        free(t->s);
-        free(t);
+/* returns 1 if key was added, 0 if it was already present */
+static int namemap_put(NameMap* m, const char* key, int val) {
+    if ((m->count + 1) * 2 > m->cap) {
+        NameMap old = *m;
+        namemap_init(m, old.cap);
+        for (int j = 0; j < old.cap; j++) {
+            if (!old.keys[j]) continue;
+            int i = namemap_slot(m, old.keys[j]);
+            m->keys[i] = old.keys[j];
+            m->vals[i] = old.vals[j];
+            m->count++;
+        }
+        free(old.keys);
+        free(old.vals);
     }
+    int i = namemap_slot(m, key);
+    if (m->keys[i]) return 0;
+    m->keys[i] = key;
+    m->vals[i] = val;
+    m->count++;
+    return 1;
 }
 
-/* Temp map: maps names (temps, params, locals) to negative rbp offsets  */
-typedef struct TempMap {
-    char *name;
-    int offset; // negative offset from %rbp (e.g. -4, -8)
-    struct TempMap *next;
-} TempMap;
-
-static TempMap* tempmap_add(TempMap* m, const char* name, int offset) {
-    TempMap* n = malloc(sizeof(TempMap));
-    n->name = strdup(name);
-    n->offset = offset;
-    n->next = m;
-    return n;
+static void namemap_free(NameMap* m) {
+    free(m->keys);
+    free(m->vals);
+    m->keys = NULL;
+    m->vals = NULL;
 }
 
-static int tempmap_get_offset(TempMap* m, const char* name) {
-    for (TempMap* t = m; t; t = t->next) if (strcmp(t->name, name) == 0) return t->offset;
-    return 0; /* caller should check existence first */
+/* Growable list of names (kept in insertion order) */
+typedef struct NameList {
+    const char **items;
+    int count, cap;
+} NameList;
+
+static void namelist_push(NameList* l, const char* s) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 16;
+        l->items = realloc(l->items, sizeof(const char*) * l->cap);
+        if (!l->items) { perror("realloc"); exit(1); }
+    }
+    l->items[l->count++] = s;
 }
 
-static void tempmap_free(TempMap* m) {
-    while (m) {
-        TempMap* t = m; m = m->next;
-        free(t->name);
-        free(t);
+/* Growable list of globals with their initial values (in declaration order) */
+typedef struct GlobalList {
+    GlobalVar *items;
+    int count, cap;
+} GlobalList;
+
+static void globallist_push(GlobalList* l, const char* name, int value) {
+    if (l->count == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 16;
+        l->items = realloc(l->items, sizeof(GlobalVar) * l->cap);
+        if (!l->items) { perror("realloc"); exit(1); }
     }
+    l->items[l->count].name = name;
+    l->items[l->count].value = value;
+    l->count++;
 }
 
-/* Helpers for assembly emission */
-static void emit(FILE* out, const char* fmt, ...) {
-    va_list ap;
-    va_start(ap, fmt);
-    vfprintf(out, fmt, ap);
-    va_end(ap);
+/* System V AMD64: first six integer arguments in registers */
+#define ARG_REGS 6
+static const char* const arg_regs[ARG_REGS] = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+
+/* Stack frame of one function region */
+typedef struct Frame {
+    const char *name;       // function label
+    TAC *begin, *end;       // instructions of the body: [begin, end)
+    TAC *body, *body_end;   // what gets emitted: [begin, end) or, at -O2,
+    TAC *owned;             // the SSA-optimized copy (owned, freed with the frame)
+    ASTNode *node;          // NODE_FUNC (NULL for extern functions)
+    NameMap vars;           // params and declared locals -> value index
+    int nvars;              // values 0..nvars-1 are vars, then the temps
+    int *locs;              // value -> register (>= 0), rbp offset (< 0) or LOC_UNUSED
+    int ntemps;
+    int nparams;
+    unsigned saved;         // registros callee-saved en uso (un bit por Reg)
+    int save_offsets[REG_COUNT];
+    int stack_size;         // bytes reserved below %rbp (16-aligned)
+} Frame;
+
+/* location of a value the optimized body never touches: no register, no slot */
+#define LOC_UNUSED INT_MAX
+
+/* Helpers for assembly emission. The common instruction shapes are
+   written piecewise into the AsmBuf, without going through a format
+   string; asmbuf_printf is left for the rare cases. */
+#define put_lit(b, s) asmbuf_put(b, s, sizeof(s) - 1)
+
+/* Internal labels take gas's local prefix .L: no identifier of the source
+   starts with '.', so they never clash with a function or a global, and
+   they stay out of the object's symbol table */
+#define TAC_LABEL_PREFIX ".L"       // TAC labels: .L<n>
+#define ASM_LABEL_PREFIX ".LASM"    // labels of the assembly itself: .LASM<n>
+
+/* generate unique asm labels for short-circuit and such: .LASM<n> */
+static int asm_new_label(GenCounters* g) {
+    return g->asm_label_count++;
 }
 
-/* generate unique asm labels for short-circuit and such */
-static int asm_label_count = 0;
-static char* asm_new_label() {
-    char buf[32];
-    sprintf(buf, "ASML%d", asm_label_count++);
-    return strdup(buf);
+static void put_label(AsmBuf* b, const char* prefix, int n) {
+    asmbuf_puts(b, prefix);
+    asmbuf_int(b, n);
 }
 
-/* detect temporary names (t0...tn) */
-static int is_temp(const char* s) {
-    if (!s) return 0;
-    if (s[0] != 't') return 0;
-    if (!isdigit((unsigned char)s[1])) return 0;
-    return 1;
+/* "prefix<n>:\n" */
+static void emit_label(AsmBuf* b, const char* prefix, int n) {
+    put_label(b, prefix, n);
+    put_lit(b, ":\n");
 }
 
-/* detect identifier (simple heuristic) */
-static int is_ident(const char* s) {
-    if (!s) return 0;
-    if (!(isalpha((unsigned char)s[0]) || s[0] == '_')) return 0;
-    return 1;
+/* "    op prefix<n>\n" (jumps) */
+static void emit_jump(AsmBuf* b, const char* op, const char* prefix, int n) {
+    put_lit(b, "    ");
+    asmbuf_puts(b, op);
+    asmbuf_putc(b, ' ');
+    put_label(b, prefix, n);
+    asmbuf_putc(b, '\n');
 }
 
-/* detect number string */
-static int is_number_str(const char* s) {
-    if (!s) return 0;
-    int i = 0;
-    if (s[0] == '-') i = 1;
-    for (; s[i]; ++i) if (!isdigit((unsigned char)s[i])) return 0;
-    return 1;
+/* value index of a temp or a variable of the function, -1 for the rest
+   (immediates, globals, labels) */
+static int value_of(const Operand* o, Frame* f) {
+    if (o->kind == OPND_TEMP) return f->nvars + o->temp;
+    if (o->kind == OPND_VAR) {
+        int* v = namemap_find(&f->vars, o->name);
+        return v ? *v : -1;
+    }
+    return -1;
 }
 
-/* print movl load to %eax for operand (temp->stack, ident->global, immediate->$imm) */
-static void emit_load_to_eax(FILE* out, const char* operand, TempMap* map) {
-    if (!operand) { emit(out, "    movl $0, %%eax\n"); return; }
-    if (is_number_str(operand)) {
-        emit(out, "    movl $%s, %%eax\n", operand);
-    } else if (is_temp(operand)) {
-        int off = tempmap_get_offset(map, operand);
-        emit(out, "    movl %d(%%rbp), %%eax\n", off);
-    } else {
-        emit(out, "    movl %s(%%rip), %%eax\n", operand);
-    }
+/* register an operand lives in, or REG_NONE */
+static int reg_of(const Operand* o, Frame* f) {
+    int v = value_of(o, f);
+    return v >= 0 && f->locs[v] >= 0 ? f->locs[v] : REG_NONE;
 }
 
-/* store %eax into dest (temp->stack or ident->global) */
-static void emit_store_eax_to(FILE* out, const char* dest, TempMap* map) {
-    if (!dest) return;
-    if (is_temp(dest)) {
-        int off = tempmap_get_offset(map, dest);
-        emit(out, "    movl %%eax, %d(%%rbp)\n", off);
+/* home of a value: its register or off(%rbp) */
+static void put_value(AsmBuf* b, Frame* f, int v) {
+    if (f->locs[v] >= 0) {
+        asmbuf_puts(b, reg_name32[f->locs[v]]);
     } else {
-        emit(out, "    movl %%eax, %s(%%rip)\n", dest);
+        asmbuf_int(b, f->locs[v]);
+        put_lit(b, "(%rbp)");
     }
 }
 
-/* Heurística globales: cualquier ASSIGN cuyo result sea identificador (no temp) -> global */
-static StrNode* collect_globals_from_tac(TAC* code) {
-    StrNode* g = NULL;
-    for (TAC* t = code; t; t = t->next) {
-        if (!t->op) continue;
-        if (strcmp(t->op, "ASSIGN") == 0) {
-            if (t->result && is_ident(t->result) && !is_temp(t->result)) {
-                g = strnode_add(g, t->result);
+/* location of an operand as an AT&T source/destination:
+   immediate -> $imm, temp/local -> register or off(%rbp),
+   global -> name(%rip) */
+static void put_loc(AsmBuf* b, const Operand* o, Frame* f) {
+    switch (o->kind) {
+        case OPND_IMM:
+            asmbuf_putc(b, '$');
+            asmbuf_int(b, o->imm);
+            break;
+        case OPND_TEMP:
+        case OPND_VAR: {
+            int v = value_of(o, f);
+            if (v >= 0) {
+                put_value(b, f, v);
+            } else {
+                asmbuf_puts(b, o->name);
+                put_lit(b, "(%rip)");
             }
+            break;
         }
+        default:
+            put_lit(b, "$0");
+            break;
     }
-    return g;
 }
 
-/* collect temps in region [start, region_end) */
-static StrNode* collect_temps_in_region(TAC* start, TAC* region_end) {
-    StrNode* temps = NULL;
-    for (TAC* t = start; t && t != region_end; t = t->next) {
-        if (!t->op) continue;
-        if (t->arg1 && is_temp(t->arg1)) temps = strnode_add(temps, t->arg1);
-        if (t->arg2 && is_temp(t->arg2)) temps = strnode_add(temps, t->arg2);
-        if (t->result && is_temp(t->result)) temps = strnode_add(temps, t->result);
+/* "    op loc, reg\n" */
+static void emit_loc_reg(AsmBuf* b, const char* op, const Operand* o, Frame* f, const char* reg) {
+    put_lit(b, "    ");
+    asmbuf_puts(b, op);
+    asmbuf_putc(b, ' ');
+    put_loc(b, o, f);
+    put_lit(b, ", ");
+    asmbuf_puts(b, reg);
+    asmbuf_putc(b, '\n');
+}
+
+/* "    op reg, off(%rbp)\n" */
+static void emit_reg_off(AsmBuf* b, const char* op, const char* reg, int off) {
+    put_lit(b, "    ");
+    asmbuf_puts(b, op);
+    asmbuf_putc(b, ' ');
+    asmbuf_puts(b, reg);
+    put_lit(b, ", ");
+    asmbuf_int(b, off);
+    put_lit(b, "(%rbp)\n");
+}
+
+/* "    movl src, value\n" (src a register or off(%rbp)) */
+static void emit_to_value(AsmBuf* b, const char* src, Frame* f, int v) {
+    put_lit(b, "    movl ");
+    asmbuf_puts(b, src);
+    put_lit(b, ", ");
+    put_value(b, f, v);
+    asmbuf_putc(b, '\n');
+}
+
+/* "    op $imm, reg\n" */
+static void emit_imm_reg(AsmBuf* b, const char* op, int imm, const char* reg) {
+    put_lit(b, "    ");
+    asmbuf_puts(b, op);
+    put_lit(b, " $");
+    asmbuf_int(b, imm);
+    put_lit(b, ", ");
+    asmbuf_puts(b, reg);
+    asmbuf_putc(b, '\n');
+}
+
+/* print movl load to %eax for operand (temp->stack, ident->global, immediate->$imm) */
+static void emit_load_to_eax(AsmBuf* out, const Operand* o, Frame* f) {
+    emit_loc_reg(out, "movl", o, f, "%eax");
+}
+
+/* store %eax into dest (temp/local->stack or ident->global) */
+static void emit_store_eax_to(AsmBuf* out, const Operand* dest, Frame* f) {
+    if (dest->kind != OPND_TEMP && dest->kind != OPND_VAR) return;
+    put_lit(out, "    movl %eax, ");
+    put_loc(out, dest, f);
+    asmbuf_putc(out, '\n');
+}
+
+/* collect local variable names declared anywhere in a function body (in order) */
+static void collect_locals(ASTNode* node, NameList* locals) {
+    if (!node) return;
+    if (node->type == NODE_DECL && node->left && node->left->type == NODE_ID)
+        namelist_push(locals, node->left->id);
+    collect_locals(ast_left(node), locals);
+    collect_locals(ast_right(node), locals);
+    for (int i = 0; i < node->child_count; ++i)
+        collect_locals(node->children[i], locals);
+}
+
+/* values each instruction of [begin, end) reads (arg1, arg2) and writes
+   (result), -1 where there is none; labels and function names are not
+   values */
+static int (*frame_values(Frame* f, TAC* begin, TAC* end))[3] {
+    int n = (int)(end - begin);
+    int (*vals)[3] = malloc(sizeof(*vals) * (n ? n : 1));
+    if (!vals) { perror("malloc"); exit(1); }
+    for (int i = 0; i < n; ++i) {
+        TAC* u = &begin[i];
+        vals[i][0] = value_of(&u->arg1, f);
+        vals[i][1] = value_of(&u->arg2, f);
+        vals[i][2] = value_of(&u->result, f);
     }
-    return temps;
+    return vals;
 }
 
-/* find next function label (LABEL whose result does NOT start with 'L' + digit) */
-static TAC* next_func_label_after(TAC* t) {
-    if (!t) return NULL;
-    for (TAC* u = t->next; u; u = u->next) {
-        if (!u->op) continue;
-        if (strcmp(u->op, "LABEL") == 0) {
-            char* r = u->result;
-            if (r && !(r[0]=='L' && isdigit((unsigned char)r[1]))) return u;
-        }
+/* registers for the values of f (from -O1 on; at -O0 all go to memory).
+   Returns the callee-saved registers used. */
+static unsigned frame_alloc_regs(Frame* f, int nvalues, signed char* reg, int opt_level) {
+    if (opt_level < 1) {
+        for (int v = 0; v < nvalues; ++v) reg[v] = REG_NONE;
+        return 0;
     }
-    return NULL;
+    int n = (int)(f->body_end - f->body);
+    int (*vals)[3] = frame_values(f, f->body, f->body_end);
+    CFG g;
+    cfg_build(&g, f->body, n);
+    unsigned used = regalloc_function(&g, (const int (*)[3])vals, nvalues, f->nparams, reg);
+    cfg_free(&g);
+    free(vals);
+    return used;
 }
 
-/* find function AST node by name */
-static ASTNode* find_func_node(ASTNode* root, const char* funcname) {
-    if (!root) return NULL;
-    if (root->type == NODE_FUNC && root->id && strcmp(root->id, funcname) == 0) return root;
-    if (root->children) {
-        for (int i = 0; i < root->child_count; ++i) {
-            ASTNode* r = find_func_node(root->children[i], funcname);
-            if (r) return r;
-        }
+/* temps are numbered densely from 0 in each function */
+static int count_temps(TAC* begin, TAC* end) {
+    int n = 0;
+    for (TAC* u = begin; u < end; u++) {
+        if (u->arg1.kind == OPND_TEMP && u->arg1.temp >= n) n = u->arg1.temp + 1;
+        if (u->arg2.kind == OPND_TEMP && u->arg2.temp >= n) n = u->arg2.temp + 1;
+        if (u->result.kind == OPND_TEMP && u->result.temp >= n) n = u->result.temp + 1;
     }
-    if (root->left) {
-        ASTNode* r = find_func_node(root->left, funcname);
-        if (r) return r;
+    return n;
+}
+
+/* -O2: run the SSA optimizations over the body; the locals they rewrite
+   become temps, so the body gets its own temp numbering */
+static void frame_optimize(Frame* f) {
+    int n = (int)(f->end - f->begin);
+    int (*vals)[3] = frame_values(f, f->begin, f->end);
+    Operand* vars = malloc(sizeof(Operand) * (f->nvars ? f->nvars : 1));
+    if (!vars) { perror("malloc"); exit(1); }
+    for (int j = 0; j < f->vars.cap; ++j) {
+        if (!f->vars.keys[j]) continue;
+        vars[f->vars.vals[j]].kind = OPND_VAR;
+        vars[f->vars.vals[j]].name = f->vars.keys[j];
     }
-    if (root->right) {
-        ASTNode* r = find_func_node(root->right, funcname);
-        if (r) return r;
+    int m;
+    TAC* code = ssa_optimize(f->begin, n, (const int (*)[3])vals, vars, f->nvars, f->ntemps, &m);
+    if (code) {
+        f->owned = f->body = code;
+        f->body_end = code + m;
+        f->ntemps = count_temps(f->body, f->body_end);
     }
-    return NULL;
+    free(vars);
+    free(vals);
 }
 
-/* get parameter names from AST function node (in order of children) */
-static StrNode* collect_param_names(ASTNode* funcnode) {
-    StrNode* p = NULL;
-    if (!funcnode) return NULL;
-    for (int i = 0; i < funcnode->child_count; ++i) {
-        ASTNode* ch = funcnode->children[i];
-        if (ch && ch->type == NODE_PARAM) {
-            p = strnode_add(p, ch->id);
+/* build the frame of function region [t, end): params -> locals -> temps,
+   each in a register or, if it got none, in a 4-byte slot; below them the
+   slots where the callee-saved registers it uses are kept */
+static void frame_build(Frame* f, TAC* t, TAC* end, Compilation* c) {
+    memset(f, 0, sizeof(*f));
+    // globals declared after the function close its region, but they are data
+    while (end > t + 1 && end[-1].op == TAC_GLOBAL) end--;
+    f->name = t->result.name;
+    f->begin = f->body = t + 1;
+    f->end = f->body_end = end;
+    FuncInfo* fi = find_function(c->funcs, f->name);
+    f->node = (fi && fi->node && fi->node->type == NODE_FUNC) ? fi->node : NULL;
+
+    NameList locals = { 0 };
+    if (f->node) collect_locals(f->node, &locals);
+    namemap_init(&f->vars, (f->node ? f->node->child_count : 0) + locals.count);
+
+    if (f->node) {
+        for (int i = 0; i < f->node->child_count; ++i) {
+            ASTNode* ch = f->node->children[i];
+            if (ch && ch->type == NODE_PARAM && namemap_put(&f->vars, ch->id, f->nvars)) {
+                f->nvars++;
+                f->nparams++;
+            }
+        }
+    }
+    for (int i = 0; i < locals.count; ++i) {
+        if (namemap_put(&f->vars, locals.items[i], f->nvars))
+            f->nvars++;
+    }
+    free(locals.items);
+
+    f->ntemps = count_temps(f->begin, f->end);
+    if (c->opt_level >= 2) frame_optimize(f);
+
+    int nvalues = f->nvars + f->ntemps;
+    f->locs = malloc(sizeof(int) * (nvalues ? nvalues : 1));
+    signed char* reg = malloc(nvalues ? nvalues : 1);
+    if (!f->locs || !reg) { perror("malloc"); exit(1); }
+    f->saved = frame_alloc_regs(f, nvalues, reg, c->opt_level);
+
+    // the optimized body leaves most locals behind: they take no slot
+    char* touched = NULL;
+    if (f->owned) {
+        touched = calloc(nvalues ? nvalues : 1, 1);
+        if (!touched) { perror("calloc"); exit(1); }
+        for (TAC* u = f->body; u < f->body_end; u++) {
+            int v;
+            if ((v = value_of(&u->arg1, f)) >= 0) touched[v] = 1;
+            if ((v = value_of(&u->arg2, f)) >= 0) touched[v] = 1;
+            if ((v = value_of(&u->result, f)) >= 0) touched[v] = 1;
         }
     }
-    return p;
-}
 
-/* collect local variable names from a BLOCK node (heurística: ASSIGN nodes direct children are var-decls) */
-static StrNode* collect_locals_from_block(ASTNode* blocknode) {
-    StrNode* locals = NULL;
-    if (!blocknode || blocknode->type != NODE_BLOCK) return NULL;
-    for (int i = 0; i < blocknode->child_count; ++i) {
-        ASTNode* ch = blocknode->children[i];
-        if (!ch) continue;
-        if (ch->type == NODE_ASSIGN && ch->left && ch->left->type == NODE_ID) {
-            locals = strnode_add(locals, ch->left->id);
+    int cur_off = -4;
+    for (int v = 0; v < nvalues; ++v) {
+        if (touched && !touched[v]) {
+            f->locs[v] = LOC_UNUSED;
+        } else if (reg[v] != REG_NONE) {
+            f->locs[v] = reg[v];
+        } else {
+            f->locs[v] = cur_off;
+            cur_off -= 4;
         }
     }
-    return locals;
+    free(reg);
+    free(touched);
+
+    // each slot 4 bytes, callee-saved registers 8, align to 16
+    int bytes_needed = -cur_off - 4;
+    if (f->saved) bytes_needed = (bytes_needed + 7) / 8 * 8;
+    for (int r = 0; r < REG_COUNT; ++r) {
+        if (!(f->saved & (1u << r))) continue;
+        bytes_needed += 8;
+        f->save_offsets[r] = -bytes_needed;
+    }
+    f->stack_size = ((bytes_needed + 15) / 16) * 16;
+}
+
+static void frame_free(Frame* f) {
+    namemap_free(&f->vars);
+    free(f->locs);
+    free(f->owned);
+}
+
+/* is t the label that starts a function region? */
+static int is_func_label(TAC* t) {
+    return t->op == TAC_LABEL && t->result.kind == OPND_FUNC;
+}
+
+/* Globales: cada una es un TAC_GLOBAL, antes de la primera función o al
+   final de la región de la función que la precede */
+static void collect_globals(GlobalList* g, TAC* begin, TAC* end) {
+    for (TAC* t = begin; t < end; t++)
+        if (t->op == TAC_GLOBAL) globallist_push(g, t->result.name, t->arg1.imm);
 }
 
 /* Emit binary op (with short-circuit for && and ||)                    */
-static void emit_binop(FILE* out, const char* op, const char* a1, const char* a2, const char* res, TempMap* map) {
-    if (!op || !res) return;
+static void emit_binop(GenCounters* g, AsmBuf* out, TacOp op, const Operand* a1, const Operand* a2, const Operand* res, Frame* f) {
+    if (res->kind == OPND_NONE) return;
     // load a1 into eax
-    emit_load_to_eax(out, a1, map);
-
-    if (strcmp(op, "+") == 0) {
-        if (is_number_str(a2)) emit(out, "    addl $%s, %%eax\n", a2);
-        else if (is_temp(a2)) emit(out, "    addl %d(%%rbp), %%eax\n", tempmap_get_offset(map, a2));
-        else emit(out, "    addl %s(%%rip), %%eax\n", a2);
-        emit_store_eax_to(out, res, map);
-    } else if (strcmp(op, "-") == 0) {
-        if (is_number_str(a2)) emit(out, "    subl $%s, %%eax\n", a2);
-        else if (is_temp(a2)) emit(out, "    subl %d(%%rbp), %%eax\n", tempmap_get_offset(map, a2));
-        else emit(out, "    subl %s(%%rip), %%eax\n", a2);
-        emit_store_eax_to(out, res, map);
-    } else if (strcmp(op, "*") == 0) {
-        if (is_number_str(a2)) emit(out, "    imull $%s, %%eax\n", a2);
-        else if (is_temp(a2)) emit(out, "    imull %d(%%rbp), %%eax\n", tempmap_get_offset(map, a2));
-        else emit(out, "    imull %s(%%rip), %%eax\n", a2);
-        emit_store_eax_to(out, res, map);
-    } else if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
+    emit_load_to_eax(out, a1, f);
+
+    switch (op) {
+    case TAC_ADD:
+        emit_loc_reg(out, "addl", a2, f, "%eax");
+        emit_store_eax_to(out, res, f);
+        break;
+    case TAC_SUB:
+        emit_loc_reg(out, "subl", a2, f, "%eax");
+        emit_store_eax_to(out, res, f);
+        break;
+    case TAC_MUL:
+        emit_loc_reg(out, "imull", a2, f, "%eax");
+        emit_store_eax_to(out, res, f);
+        break;
+    case TAC_DIV:
+    case TAC_MOD:
         // divisor -> ecx
-        if (is_number_str(a2)) emit(out, "    movl $%s, %%ecx\n", a2);
-        else if (is_temp(a2)) emit(out, "    movl %d(%%rbp), %%ecx\n", tempmap_get_offset(map, a2));
-        else emit(out, "    movl %s(%%rip), %%ecx\n", a2);
-        emit(out, "    cltd\n    idivl %%ecx\n"); // quotient->eax remainder->edx
-        if (strcmp(op, "/") == 0) emit_store_eax_to(out, res, map);
+        emit_loc_reg(out, "movl", a2, f, "%ecx");
+        put_lit(out, "    cltd\n    idivl %ecx\n"); // quotient->eax remainder->edx
+        if (op == TAC_DIV) emit_store_eax_to(out, res, f);
         else {
-            emit(out, "    movl %%edx, %%eax\n");
-            emit_store_eax_to(out, res, map);
+            put_lit(out, "    movl %edx, %eax\n");
+            emit_store_eax_to(out, res, f);
         }
-    } else if (strcmp(op, "==") == 0 || strcmp(op, "<") == 0 || strcmp(op, ">") == 0) {
-        if (is_number_str(a2)) emit(out, "    cmpl $%s, %%eax\n", a2);
-        else if (is_temp(a2)) emit(out, "    cmpl %d(%%rbp), %%eax\n", tempmap_get_offset(map, a2));
-        else emit(out, "    cmpl %s(%%rip), %%eax\n", a2);
-        if (strcmp(op, "==") == 0) emit(out, "    sete %%al\n");
-        else if (strcmp(op, "<") == 0) emit(out, "    setl %%al\n");
-        else emit(out, "    setg %%al\n");
-        emit(out, "    movzbl %%al, %%eax\n");
-        emit_store_eax_to(out, res, map);
-    } else if (strcmp(op, "&&") == 0) {
+        break;
+    case TAC_EQ:
+    case TAC_LT:
+    case TAC_GT:
+        emit_loc_reg(out, "cmpl", a2, f, "%eax");
+        if (op == TAC_EQ) put_lit(out, "    sete %al\n");
+        else if (op == TAC_LT) put_lit(out, "    setl %al\n");
+        else put_lit(out, "    setg %al\n");
+        put_lit(out, "    movzbl %al, %eax\n");
+        emit_store_eax_to(out, res, f);
+        break;
+    case TAC_AND: {
         // short-circuit AND
-        char* Lfalse = asm_new_label();
-        char* Lend = asm_new_label();
+        int Lfalse = asm_new_label(g);
+        int Lend = asm_new_label(g);
 
-        emit(out, "    cmpl $0, %%eax\n");
-        emit(out, "    je %s\n", Lfalse);
+        put_lit(out, "    cmpl $0, %eax\n");
+        emit_jump(out, "je", ASM_LABEL_PREFIX, Lfalse);
 
         // evaluate b
-        if (is_number_str(a2)) emit(out, "    movl $%s, %%eax\n", a2);
-        else if (is_temp(a2)) emit(out, "    movl %d(%%rbp), %%eax\n", tempmap_get_offset(map, a2));
-        else emit(out, "    movl %s(%%rip), %%eax\n", a2);
+        emit_load_to_eax(out, a2, f);
 
-        emit(out, "    cmpl $0, %%eax\n    setne %%al\n    movzbl %%al, %%eax\n");
-        emit_store_eax_to(out, res, map);
-        emit(out, "    jmp %s\n", Lend);
+        put_lit(out, "    cmpl $0, %eax\n    setne %al\n    movzbl %al, %eax\n");
+        emit_store_eax_to(out, res, f);
+        emit_jump(out, "jmp", ASM_LABEL_PREFIX, Lend);
 
-        emit(out, "%s:\n", Lfalse);
-        emit(out, "    movl $0, %%eax\n");
-        emit_store_eax_to(out, res, map);
+        emit_label(out, ASM_LABEL_PREFIX, Lfalse);
+        put_lit(out, "    movl $0, %eax\n");
+        emit_store_eax_to(out, res, f);
 
-        emit(out, "%s:\n", Lend);
-        free(Lfalse); free(Lend);
-    } else if (strcmp(op, "||") == 0) {
+        emit_label(out, ASM_LABEL_PREFIX, Lend);
+        break;
+    }
+    case TAC_OR: {
         // short-circuit OR
-        char* Ltrue = asm_new_label();
-        char* Lend = asm_new_label();
+        int Ltrue = asm_new_label(g);
+        int Lend = asm_new_label(g);
 
-        emit(out, "    cmpl $0, %%eax\n");
-        emit(out, "    jne %s\n", Ltrue);
+        put_lit(out, "    cmpl $0, %eax\n");
+        emit_jump(out, "jne", ASM_LABEL_PREFIX, Ltrue);
 
         // evaluate b
-        if (is_number_str(a2)) emit(out, "    movl $%s, %%eax\n", a2);
-        else if (is_temp(a2)) emit(out, "    movl %d(%%rbp), %%eax\n", tempmap_get_offset(map, a2));
-        else emit(out, "    movl %s(%%rip), %%eax\n", a2);
+        emit_load_to_eax(out, a2, f);
 
-        emit(out, "    cmpl $0, %%eax\n    setne %%al\n    movzbl %%al, %%eax\n");
-        emit_store_eax_to(out, res, map);
-        emit(out, "    jmp %s\n", Lend);
+        put_lit(out, "    cmpl $0, %eax\n    setne %al\n    movzbl %al, %eax\n");
+        emit_store_eax_to(out, res, f);
+        emit_jump(out, "jmp", ASM_LABEL_PREFIX, Lend);
 
-        emit(out, "%s:\n", Ltrue);
-        emit(out, "    movl $1, %%eax\n");
-        emit_store_eax_to(out, res, map);
+        emit_label(out, ASM_LABEL_PREFIX, Ltrue);
+        put_lit(out, "    movl $1, %eax\n");
+        emit_store_eax_to(out, res, f);
 
-        emit(out, "%s:\n", Lend);
-        free(Ltrue); free(Lend);
-    } else {
+        emit_label(out, ASM_LABEL_PREFIX, Lend);
+        break;
+    }
+    case TAC_NOT:
+        put_lit(out, "    cmpl $0, %eax\n    sete %al\n    movzbl %al, %eax\n");
+        emit_store_eax_to(out, res, f);
+        break;
+    case TAC_NEG:
+        put_lit(out, "    negl %eax\n");
+        emit_store_eax_to(out, res, f);
+        break;
+    default:
         // fallback: simply store a1
-        emit_store_eax_to(out, res, map);
+        emit_store_eax_to(out, res, f);
+        break;
     }
 }
 
-/* Main generator: gen_asm  */
-void gen_asm(TAC* code, ASTNode* ast_root, FILE* out) {
-    if (!code || !out) return;
-
-    // collect globals
-    StrNode* globals = collect_globals_from_tac(code);
-
-    // header
-    emit(out, "    .text\n");
-    emit(out, "    .global main\n\n");
-
-    // data
-    emit(out, "    .section .data\n");
-    for (StrNode* g = globals; g; g = g->next) {
-        emit(out, "%s:\n    .long 0\n", g->s);
-    }
-    emit(out, "\n    .section .text\n");
-
-    // walk TAC, find function labels
-    for (TAC* t = code; t; ) {
-        // find next function label
-        while (t && !(t->op && strcmp(t->op, "LABEL") == 0 &&
-                      t->result && !(t->result[0]=='L' && isdigit((unsigned char)t->result[1]))))
-            t = t->next;
-        if (!t) break;
-
-        char* funcname = t->result;
-        TAC* next_func = next_func_label_after(t);
-
-        // collect temps in region for the function (exclusive of next_func)
-        StrNode* temps = collect_temps_in_region(t->next, next_func);
-
-        // locate AST function node to get params and locals
-        ASTNode* funcnode = find_func_node(ast_root, funcname);
-        StrNode* params = collect_param_names(funcnode);
-        StrNode* locals = NULL;
-        // find body block if available (last child that is BLOCK)
-        ASTNode* body = NULL;
-        if (funcnode) {
-            for (int i = 0; i < funcnode->child_count; ++i) {
-                if (funcnode->children[i] && funcnode->children[i]->type == NODE_BLOCK) {
-                    body = funcnode->children[i];
-                    break;
-                }
+/* CALL func, nargs -> result. Its nargs PARAMs are the instructions right
+   before it. They can be loaded in any order: a value lives in a stack slot
+   or in a register the allocator hands out, never in an argument register
+   nor in %eax/%ecx/%edx.
+   The frame keeps %rsp 16-aligned, stack arguments are padded to keep it so. */
+static void emit_call(AsmBuf* out, TAC* call, Frame* f) {
+    int n = call->arg2.kind == OPND_IMM ? call->arg2.imm : 0;
+    TAC* params = call - n;
+    int nstack = n > ARG_REGS ? n - ARG_REGS : 0;
+    int pad = (nstack % 2) ? 8 : 0;
+
+    if (pad) put_lit(out, "    subq $8, %rsp\n");
+    for (int i = n - 1; i >= ARG_REGS; --i) {
+        emit_load_to_eax(out, &params[i].arg1, f);
+        put_lit(out, "    pushq %rax\n");
+    }
+    // no value lives in an argument register, so the order does not matter
+    for (int i = 0; i < n && i < ARG_REGS; ++i)
+        emit_loc_reg(out, "movl", &params[i].arg1, f, arg_regs[i]);
+
+    put_lit(out, "    call ");
+    asmbuf_puts(out, call->arg1.name);
+    asmbuf_putc(out, '\n');
+    if (nstack || pad) emit_imm_reg(out, "addq", nstack * 8 + pad, "%rsp");
+    emit_store_eax_to(out, &call->result, f);
+}
+
+/* .LASM labels emit_binop will take for the region (two per AND/OR);
+   must match emit_binop */
+static int asm_labels_used(TAC* begin, TAC* end) {
+    int n = 0;
+    for (TAC* t = begin; t < end; t++)
+        if ((t->op == TAC_AND || t->op == TAC_OR) && t->result.kind != OPND_NONE)
+            n += 2;
+    return n;
+}
+
+/* "    testl/cmpl o\n    jcc L<label>\n": jump on o being zero (je) or
+   not (jne) */
+static void emit_test_jump(AsmBuf* out, const Operand* o, Frame* f, const char* jcc, int label) {
+    int r = reg_of(o, f);
+    if (r != REG_NONE) {
+        put_lit(out, "    testl ");
+        asmbuf_puts(out, reg_name32[r]);
+        put_lit(out, ", ");
+        asmbuf_puts(out, reg_name32[r]);
+        asmbuf_putc(out, '\n');
+    } else {
+        emit_load_to_eax(out, o, f);
+        put_lit(out, "    cmpl $0, %eax\n");
+    }
+    emit_jump(out, jcc, TAC_LABEL_PREFIX, label);
+}
+
+/* reads of each temp in the body */
+static int* count_temp_reads(Frame* f) {
+    int* reads = calloc(f->ntemps ? f->ntemps : 1, sizeof(int));
+    if (!reads) { perror("calloc"); exit(1); }
+    for (TAC* t = f->body; t < f->body_end; t++) {
+        if (t->arg1.kind == OPND_TEMP) reads[t->arg1.temp]++;
+        if (t->arg2.kind == OPND_TEMP) reads[t->arg2.temp]++;
+    }
+    return reads;
+}
+
+/* does t write a temp that only next reads (as its condition/operand)? */
+static int feeds(const TAC* t, const TAC* next, const int* reads) {
+    return t->result.kind == OPND_TEMP && reads[t->result.temp] == 1 &&
+           next->arg1.kind == OPND_TEMP && next->arg1.temp == t->result.temp;
+}
+
+/* A comparison that only decides a branch is a cmpl and a conditional
+   jump, without setcc, store, reload and test: LT/GT/EQ then IF_FALSE
+   jumps on the opposite condition, LT/GT/EQ, NOT, IF_FALSE on the
+   condition itself, and NOT then IF_FALSE on a non-zero operand. Returns
+   how many instructions it took (0: none of these shapes). */
+static int emit_fused_branch(AsmBuf* out, TAC* cur, TAC* end, const int* reads, Frame* f) {
+    int is_cmp = cur->op == TAC_LT || cur->op == TAC_GT || cur->op == TAC_EQ;
+    if (!is_cmp && cur->op != TAC_NOT) return 0;
+    if (cur + 1 >= end || !feeds(cur, cur + 1, reads)) return 0;
+    if (cur->op == TAC_NOT) {
+        if (cur[1].op != TAC_IF_FALSE_GOTO) return 0;
+        emit_test_jump(out, &cur->arg1, f, "jne", cur[1].result.label);
+        return 2;
+    }
+
+    int negated = 0;
+    TAC* branch = cur + 1;
+    if (branch->op == TAC_NOT && branch + 1 < end && feeds(branch, branch + 1, reads)) {
+        negated = 1;
+        branch++;
+    }
+    if (branch->op != TAC_IF_FALSE_GOTO) return 0;
+
+    // jump when the comparison is false, or true under a NOT
+    static const char* const when_false[] = { [TAC_LT] = "jge", [TAC_GT] = "jle", [TAC_EQ] = "jne" };
+    static const char* const when_true[] = { [TAC_LT] = "jl", [TAC_GT] = "jg", [TAC_EQ] = "je" };
+    int r = reg_of(&cur->arg1, f);
+    if (r != REG_NONE) {
+        emit_loc_reg(out, "cmpl", &cur->arg2, f, reg_name32[r]);
+    } else {
+        emit_load_to_eax(out, &cur->arg1, f);
+        emit_loc_reg(out, "cmpl", &cur->arg2, f, "%eax");
+    }
+    emit_jump(out, negated ? when_true[cur->op] : when_false[cur->op], TAC_LABEL_PREFIX, branch->result.label);
+    return (int)(branch - cur) + 1;
+}
+
+/* restore the callee-saved registers, drop the frame and return */
+static void emit_epilogue(AsmBuf* out, Frame* f) {
+    for (int r = 0; r < REG_COUNT; ++r) {
+        if (!(f->saved & (1u << r))) continue;
+        put_lit(out, "    movq ");
+        asmbuf_int(out, f->save_offsets[r]);
+        put_lit(out, "(%rbp), ");
+        asmbuf_puts(out, reg_name64[r]);
+        asmbuf_putc(out, '\n');
+    }
+    if (f->stack_size > 0) emit_imm_reg(out, "addq", f->stack_size, "%rsp");
+    put_lit(out, "    popq %rbp\n    ret\n");
+}
+
+/* emit one function: prologue, body, epilogue */
+static void emit_function(GenCounters* g, AsmBuf* out, Frame* f) {
+    int asm_label_base = g->asm_label_count;
+    // emit prologue; every function is visible to the linker, as in C, so
+    // that several files can be linked together (main is declared above)
+    if (strcmp(f->name, "main") != 0) {
+        put_lit(out, "    .global ");
+        asmbuf_puts(out, f->name);
+        asmbuf_putc(out, '\n');
+    }
+    asmbuf_puts(out, f->name);
+    put_lit(out, ":\n    pushq %rbp\n    movq %rsp, %rbp\n");
+    if (f->stack_size > 0) emit_imm_reg(out, "subq", f->stack_size, "%rsp");
+    for (int r = 0; r < REG_COUNT; ++r)
+        if (f->saved & (1u << r)) emit_reg_off(out, "movq", reg_name64[r], f->save_offsets[r]);
+
+    // copy parameters to their homes (System V: the first six come in
+    // registers, the rest were pushed by the caller: 7th at 16(%rbp), ...)
+    for (int i = 0; i < f->nparams; ++i) {
+        if (f->locs[i] == LOC_UNUSED) continue;
+        if (i < ARG_REGS) {
+            emit_to_value(out, arg_regs[i], f, i);
+        } else {
+            put_lit(out, "    movl ");
+            asmbuf_int(out, 16 + 8 * (i - ARG_REGS));
+            if (f->locs[i] >= 0) {
+                put_lit(out, "(%rbp), ");
+                asmbuf_puts(out, reg_name32[f->locs[i]]);
+                asmbuf_putc(out, '\n');
+            } else {
+                put_lit(out, "(%rbp), %eax\n");
+                emit_to_value(out, "%eax", f, i);
             }
-            if (body) locals = collect_locals_from_block(body);
         }
+    }
 
-        // assign offsets: param slots first, then locals, then temps
-        TempMap* tmap = NULL;
-        int count_params = 0; for (StrNode* s = params; s; s = s->next) ++count_params;
-        int count_locals = 0; for (StrNode* s = locals; s; s = s->next) ++count_locals;
-        int count_temps = 0; for (StrNode* s = temps; s; s = s->next) ++count_temps;
-
-        // each slot 4 bytes, align to 16 bytes total
-        int total_slots = count_params + count_locals + count_temps;
-        int bytes_needed = total_slots * 4;
-        // align to 16
-        int stack_for_locals = ((bytes_needed + 15) / 16) * 16;
-        if (stack_for_locals == 0) stack_for_locals = 0;
-
-        // mapping: we will fill mapping in order: params -> locals -> temps
-        int cur_off = -4;
-        for (StrNode* s = params; s; s = s->next) {
-            tmap = tempmap_add(tmap, s->s, cur_off);
-            cur_off -= 4;
+    // process TAC instructions in function region
+    int* reads = count_temp_reads(f);
+    for (TAC* cur = f->body; cur < f->body_end; cur++) {
+        int fused = emit_fused_branch(out, cur, f->body_end, reads, f);
+        if (fused) {
+            cur += fused - 1;
+            continue;
         }
-        for (StrNode* s = locals; s; s = s->next) {
-            tmap = tempmap_add(tmap, s->s, cur_off);
-            cur_off -= 4;
+        switch (cur->op) {
+        case TAC_LABEL:
+            emit_label(out, TAC_LABEL_PREFIX, cur->result.label);
+            break;
+        case TAC_COPY:
+        case TAC_ASSIGN: {
+            // tX = literal/ident, var = x; with a register on either side
+            // it is a single move
+            int src = reg_of(&cur->arg1, f);
+            int dst = reg_of(&cur->result, f);
+            if (dst != REG_NONE && dst == src) break;
+            if (dst != REG_NONE) {
+                emit_loc_reg(out, "movl", &cur->arg1, f, reg_name32[dst]);
+            } else if (src != REG_NONE &&
+                       (cur->result.kind == OPND_TEMP || cur->result.kind == OPND_VAR)) {
+                put_lit(out, "    movl ");
+                asmbuf_puts(out, reg_name32[src]);
+                put_lit(out, ", ");
+                put_loc(out, &cur->result, f);
+                asmbuf_putc(out, '\n');
+            } else {
+                emit_load_to_eax(out, &cur->arg1, f);
+                emit_store_eax_to(out, &cur->result, f);
+            }
+            break;
         }
-        for (StrNode* s = temps; s; s = s->next) {
-            tmap = tempmap_add(tmap, s->s, cur_off);
-            cur_off -= 4;
+        case TAC_IF_FALSE_GOTO:
+            // ifFalse arg1 goto result
+            emit_test_jump(out, &cur->arg1, f, "je", cur->result.label);
+            break;
+        case TAC_GOTO:
+            emit_jump(out, "jmp", TAC_LABEL_PREFIX, cur->result.label);
+            break;
+        case TAC_RETURN:
+            if (cur->arg1.kind != OPND_NONE) emit_load_to_eax(out, &cur->arg1, f);
+            emit_epilogue(out, f);
+            break;
+        case TAC_PARAM:
+            // arguments are passed by the CALL that follows them
+            break;
+        case TAC_CALL:
+            emit_call(out, cur, f);
+            break;
+        default:
+            // expression operators (binary and unary)
+            emit_binop(g, out, cur->op, &cur->arg1, &cur->arg2, &cur->result, f);
+            break;
         }
+    }
 
-        // emit prologue
-        emit(out, "%s:\n", funcname);
-        emit(out, "    pushq %%rbp\n");
-        emit(out, "    movq %%rsp, %%rbp\n");
-        if (stack_for_locals > 0) emit(out, "    subq $%d, %%rsp\n", stack_for_locals);
-
-        // copy parameters from caller stack into local slots
-        // caller pushed args (8 bytes each); in callee after prologue:
-        // first arg is at 16(%rbp), second at 24(%rbp), ...
-        if (count_params > 0) {
-            int i = 0;
-            int base = 16;
-            for (StrNode* s = params; s; s = s->next) {
-                int dest = tempmap_get_offset(tmap, s->s);
-                emit(out, "    movl %d(%%rbp), %%eax\n", base + 8 * i);
-                emit(out, "    movl %%eax, %d(%%rbp)\n", dest);
-                ++i;
-            }
+    free(reads);
+
+    // if no explicit return, epilog
+    emit_epilogue(out, f);
+    asmbuf_putc(out, '\n');
+
+    // .LASM numbering follows the unoptimized body, as the parallel chunks
+    // assume, even if -O2 dropped some && or ||
+    g->asm_label_count = asm_label_base + asm_labels_used(f->begin, f->end);
+}
+
+/* Parallel emission: a run of consecutive functions [first, last) per
+   chunk, into a private buffer, with its .LASM numbering starting where the
+   serial order would. */
+typedef struct AsmChunk {
+    int first, last;
+    AsmBuf text;
+    GenCounters gen;
+} AsmChunk;
+
+typedef struct AsmJob {
+    Compilation *c;
+    Frame *frames;
+    TAC **regions;          // start of function i; regions[n] = end
+    AsmChunk *chunks;
+} AsmJob;
+
+static void emit_chunk(void* arg, int i) {
+    AsmJob* job = arg;
+    AsmChunk* ch = &job->chunks[i];
+    for (int k = ch->first; k < ch->last; ++k) {
+        frame_build(&job->frames[k], job->regions[k], job->regions[k + 1], job->c);
+        emit_function(&ch->gen, &ch->text, &job->frames[k]);
+    }
+}
+
+/* split TAC into function regions: regions[i] is the label of function i
+   and regions[n] = end (so regions[0] is also the end of the code before
+   the first function). Returns n. */
+static int split_regions(TacList* code, TAC*** out_regions) {
+    TAC* end = code->code + code->count;
+    int n = 0;
+    for (TAC* t = code->code; t < end; t++)
+        if (is_func_label(t)) ++n;
+    TAC** regions = malloc(sizeof(TAC*) * (n + 1));
+    if (!regions) { perror("malloc"); exit(1); }
+    int k = 0;
+    for (TAC* t = code->code; t < end; t++)
+        if (is_func_label(t)) regions[k++] = t;
+    regions[n] = end;
+    *out_regions = regions;
+    return n;
+}
+
+static void emit_data(AsmBuf* out, const GlobalVar* globals, int nglobals) {
+    put_lit(out, "    .section .data\n");
+    for (int i = 0; i < nglobals; ++i) {
+        asmbuf_puts(out, globals[i].name);
+        put_lit(out, ":\n    .long ");
+        asmbuf_int(out, globals[i].value);
+        asmbuf_putc(out, '\n');
+    }
+}
+
+/* Main generator: gen_asm  */
+void gen_asm(Compilation* c, TacList* code, AsmBuf* out) {
+    if (!code || !code->count || !out) return;
+
+    // split TAC into function regions and build their frames
+    TAC** regions;
+    int nframes = split_regions(code, &regions);
+    Frame* frames = malloc(sizeof(Frame) * (nframes ? nframes : 1));
+
+    // with -fparallel-codegen runs of functions go to their own buffers
+    AsmJob job = { c, frames, regions, NULL };
+    int nchunks = 0;
+    if (c->codegen_threads > 1 && nframes > 1) {
+        int per_chunk = (nframes + c->codegen_threads * PARALLEL_CHUNKS_PER_THREAD - 1)
+                        / (c->codegen_threads * PARALLEL_CHUNKS_PER_THREAD);
+        nchunks = (nframes + per_chunk - 1) / per_chunk;
+        job.chunks = calloc(nchunks, sizeof(AsmChunk));
+        if (!job.chunks) { perror("calloc"); exit(1); }
+        int base = c->gen.asm_label_count;
+        for (int i = 0; i < nchunks; ++i) {
+            AsmChunk* ch = &job.chunks[i];
+            ch->first = i * per_chunk;
+            ch->last = ch->first + per_chunk < nframes ? ch->first + per_chunk : nframes;
+            ch->gen.asm_label_count = base;
+            base += asm_labels_used(regions[ch->first] + 1, regions[ch->last]);
         }
+        parallel_for(nchunks, c->codegen_threads, emit_chunk, &job);
+        c->gen.asm_label_count = base;
+    } else {
+        for (int i = 0; i < nframes; ++i)
+            frame_build(&frames[i], regions[i], regions[i + 1], c);
+    }
 
-        // process TAC instructions in function region
-        for (TAC* cur = t->next; cur && cur != next_func; cur = cur->next) {
-            if (!cur->op) continue;
-
-            if (strcmp(cur->op, "LABEL") == 0) {
-                if (cur->result) emit(out, "%s:\n", cur->result);
-            } else if (strcmp(cur->op, "=") == 0 && cur->result && is_temp(cur->result)) {
-                // tX = literal OR tX = ident
-                if (cur->arg1 && is_number_str(cur->arg1)) {
-                    emit(out, "    movl $%s, %%eax\n", cur->arg1);
-                } else if (cur->arg1 && is_temp(cur->arg1)) {
-                    emit(out, "    movl %d(%%rbp), %%eax\n", tempmap_get_offset(tmap, cur->arg1));
-                } else if (cur->arg1 && is_ident(cur->arg1)) {
-                    emit(out, "    movl %s(%%rip), %%eax\n", cur->arg1);
-                } else {
-                    emit(out, "    movl $0, %%eax\n");
-                }
-                emit(out, "    movl %%eax, %d(%%rbp)\n", tempmap_get_offset(tmap, cur->result));
-            } else if (strcmp(cur->op, "ASSIGN") == 0) {
-                // ASSIGN arg1 -> result (result is ident or temp)
-                if (cur->arg1 && is_number_str(cur->arg1)) emit(out, "    movl $%s, %%eax\n", cur->arg1);
-                else if (cur->arg1 && is_temp(cur->arg1)) emit(out, "    movl %d(%%rbp), %%eax\n", tempmap_get_offset(tmap, cur->arg1));
-                else if (cur->arg1 && is_ident(cur->arg1)) emit(out, "    movl %s(%%rip), %%eax\n", cur->arg1);
-                else emit(out, "    movl $0, %%eax\n");
-
-                if (cur->result && is_ident(cur->result) && !is_temp(cur->result)) {
-                    emit(out, "    movl %%eax, %s(%%rip)\n", cur->result);
-                } else if (cur->result && is_temp(cur->result)) {
-                    emit(out, "    movl %%eax, %d(%%rbp)\n", tempmap_get_offset(tmap, cur->result));
-                }
-            } else if (strcmp(cur->op, "IF_FALSE_GOTO") == 0) {
-                // ifFalse arg1 goto result
-                if (cur->arg1 && is_temp(cur->arg1)) emit(out, "    movl %d(%%rbp), %%eax\n", tempmap_get_offset(tmap, cur->arg1));
-                else if (cur->arg1 && is_number_str(cur->arg1)) emit(out, "    movl $%s, %%eax\n", cur->arg1);
-                else if (cur->arg1 && is_ident(cur->arg1)) emit(out, "    movl %s(%%rip), %%eax\n", cur->arg1);
-                else emit(out, "    movl $0, %%eax\n");
-                emit(out, "    cmpl $0, %%eax\n");
-                emit(out, "    je %s\n", cur->result ? cur->result : "L_unknown");
-            } else if (strcmp(cur->op, "GOTO") == 0) {
-                emit(out, "    jmp %s\n", cur->result ? cur->result : "L_unknown");
-            } else if (strcmp(cur->op, "RETURN") == 0) {
-                if (cur->arg1) {
-                    if (is_temp(cur->arg1)) emit(out, "    movl %d(%%rbp), %%eax\n", tempmap_get_offset(tmap, cur->arg1));
-                    else if (is_number_str(cur->arg1)) emit(out, "    movl $%s, %%eax\n", cur->arg1);
-                    else emit(out, "    movl %s(%%rip), %%eax\n", cur->arg1);
-                }
-                // epilog
-                if (stack_for_locals > 0) emit(out, "    addq $%d, %%rsp\n", stack_for_locals);
-                emit(out, "    popq %%rbp\n");
-                emit(out, "    ret\n");
-            } else if (strcmp(cur->op, "PARAM") == 0) {
-                // push param (caller-side), here we simply encode pushq immediate or reg value
-                if (cur->arg1) {
-                    if (is_number_str(cur->arg1)) emit(out, "    pushq $%s\n", cur->arg1);
-                    else if (is_temp(cur->arg1)) emit(out, "    movl %d(%%rbp), %%eax\n    pushq %%rax\n", tempmap_get_offset(tmap, cur->arg1));
-                    else emit(out, "    movl %s(%%rip), %%eax\n    pushq %%rax\n", cur->arg1);
-                } else {
-                    emit(out, "    pushq $0\n");
-                }
-            } else if (strcmp(cur->op, "CALL") == 0) {
-                // CALL func, nargs -> result (result may be temp)
-                emit(out, "    call %s\n", cur->arg1 ? cur->arg1 : "unknown_func");
-                if (cur->result && is_temp(cur->result)) {
-                    emit(out, "    movl %%eax, %d(%%rbp)\n", tempmap_get_offset(tmap, cur->result));
-                }
-                if (cur->arg2) {
-                    int nargs = atoi(cur->arg2);
-                    if (nargs > 0) emit(out, "    addq $%d, %%rsp\n", nargs * 8);
-                }
-            } else {
-                // fallback: treat as binary op if possible
-                if (cur->result && cur->arg1) {
-                    emit_binop(out, cur->op, cur->arg1, cur->arg2, cur->result, tmap);
-                }
-            }
-        } // end for cur
+    // header and data
+    GlobalList globals = { 0 };
+    collect_globals(&globals, code->code, code->code + code->count);
+    gen_asm_prologue(out, globals.items, globals.count);
 
-        // if no explicit return, epilog
-        if (stack_for_locals > 0) emit(out, "    addq $%d, %%rsp\n", stack_for_locals);
-        emit(out, "    popq %%rbp\n");
-        emit(out, "    ret\n\n");
+    for (int i = 0; i < nchunks; ++i) {
+        asmbuf_append(out, &job.chunks[i].text);
+        asmbuf_free(&job.chunks[i].text);
+    }
+    for (int i = 0; i < nframes; ++i) {
+        if (!job.chunks) emit_function(&c->gen, out, &frames[i]);
+        frame_free(&frames[i]);
+    }
 
-        // cleanup for this function
-        strnode_free(temps);
-        strnode_free(params);
-        strnode_free(locals);
-        tempmap_free(tmap);
+    gen_asm_epilogue(out);
 
-        // advance t to next function label
-        t = next_func ? next_func : NULL;
-    } // end for functions
+    free(frames);
+    free(regions);
+    free(job.chunks);
+    free(globals.items);
+}
+
+/* Streaming: functions are emitted one at a time, as they are parsed, and
+   the data section goes at the end once every global has been seen */
+typedef struct AsmGlobals {
+    GlobalList list;        // in declaration order, like gen_asm
+} AsmGlobals;
+
+void gen_asm_begin(Compilation* c, AsmBuf* out) {
+    c->asm_globals = calloc(1, sizeof(AsmGlobals));
+    if (!c->asm_globals) { perror("calloc"); exit(1); }
+    put_lit(out, "    .text\n    .global main\n\n");
+}
 
-    strnode_free(globals);
+/* emit the functions of code one frame at a time, collecting globals */
+static void emit_regions(Compilation* c, TacList* code, GenCounters* g, AsmBuf* out,
+                         GlobalList* globals) {
+    TAC** regions;
+    int nframes = split_regions(code, &regions);
+    collect_globals(globals, code->code, code->code + code->count);
+    for (int i = 0; i < nframes; ++i) {
+        Frame f;
+        frame_build(&f, regions[i], regions[i + 1], c);
+        emit_function(g, out, &f);
+        frame_free(&f);
+    }
+    free(regions);
+}
+
+void gen_asm_func(Compilation* c, TacList* code, AsmBuf* out) {
+    if (!code || !code->count) return;
+    emit_regions(c, code, &c->gen, out, &c->asm_globals->list);
 }
 
+void gen_asm_end(Compilation* c, AsmBuf* out) {
+    AsmGlobals* g = c->asm_globals;
+    if (!g) return;
+    emit_data(out, g->list.items, g->list.count);
+    gen_asm_epilogue(out);
+    gen_asm_discard(c);
+}
+
+void gen_asm_discard(Compilation* c) {
+    AsmGlobals* g = c->asm_globals;
+    if (!g) return;
+    free(g->list.items);
+    free(g);
+    c->asm_globals = NULL;
+}
+
+/* Incremental cache support: the pieces of gen_asm, one unit at a time */
+void gen_asm_unit(Compilation* c, TacList* code, GenCounters* g, AsmBuf* out,
+                  GlobalVar** globals, int* nglobals) {
+    GlobalList list = { 0 };
+    if (code && code->count) emit_regions(c, code, g, out, &list);
+    *globals = list.items;
+    *nglobals = list.count;
+}
+
+/* If s starts with prefix followed by a number that ends the token (':' or
+   end of line), return where the digits start */
+static const char* label_digits(const char* s, const char* end, const char* prefix) {
+    size_t n = strlen(prefix);
+    if ((size_t)(end - s) <= n || memcmp(s, prefix, n) != 0) return NULL;
+    const char* d = s + n;
+    const char* e = d;
+    while (e < end && *e >= '0' && *e <= '9') e++;
+    if (e == d || (e < end && *e != ':' && *e != '\n')) return NULL;
+    return d;
+}
+
+/* Copy text shifting internal labels, which only appear as a label
+   definition at column 0 (emit_label) or as the operand of a jump
+   (emit_jump). Their .L prefix cannot be the start of a user symbol. */
+void gen_asm_rebase(AsmBuf* out, const char* text, size_t len, int label_base, int asm_label_base) {
+    if (len == 0) return;
+    if (!label_base && !asm_label_base) {
+        asmbuf_put(out, text, len);
+        return;
+    }
+    const char* p = text;
+    const char* end = text + len;
+    while (p < end) {
+        const char* nl = memchr(p, '\n', end - p);
+        const char* line_end = nl ? nl + 1 : end;
+        const char* tok = p;
+        if (line_end - p > 5 && memcmp(p, "    j", 5) == 0) {
+            tok = memchr(p + 4, ' ', line_end - p - 4);
+            tok = tok ? tok + 1 : line_end;
+        }
+        const char* d;
+        int base = 0;
+        if ((d = label_digits(tok, line_end, ASM_LABEL_PREFIX))) base = asm_label_base;
+        else if ((d = label_digits(tok, line_end, TAC_LABEL_PREFIX))) base = label_base;
+        if (d && base) {
+            char* e;
+            long n = strtol(d, &e, 10);
+            asmbuf_put(out, p, d - p);
+            asmbuf_int(out, n + base);
+            asmbuf_put(out, e, line_end - e);
+        } else {
+            asmbuf_put(out, p, line_end - p);
+        }
+        p = line_end;
+    }
+}
+
+void gen_asm_prologue(AsmBuf* out, const GlobalVar* globals, int nglobals) {
+    put_lit(out, "    .text\n    .global main\n\n");
+    emit_data(out, globals, nglobals);
+    put_lit(out, "\n    .section .text\n");
+}
+
+void gen_asm_epilogue(AsmBuf* out) {
+    // the generated code never needs an executable stack
+    put_lit(out, "    .section .note.GNU-stack,\"\",@progbits\n");
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "compilation.h"
+#include "codegen.h"
+#include "cache.h"
+#include "calc-sintaxis.tab.h"
+
+/* Generadas por flex con %option reentrant; no hay un header propio */
+int yylex_init_extra(Compilation* extra, yyscan_t* scanner);
+void yyset_in(FILE* in, yyscan_t scanner);
+int yylex_destroy(yyscan_t scanner);
+
+void compilation_init(Compilation* c, const char* input, const char* output) {
+    memset(c, 0, sizeof(*c));
+    c->input = input;
+    c->output = output;
+    c->opt_level = 1;
+    c->codegen_threads = 1;
+    c->in = stdin;
+    c->diag = stderr;
+    c->out = stdout;
+    c->current_scope = create_scope(NULL);  // scope raíz del programa
+    c->funcs = create_functable();
+    c->current_return_type = TYPE_VOID;
+    c->out_fd = -1;
+}
+
+/* ---------- Modo streaming ----------
+ * El assembly de cada función se agrega a asm_text y se vuelca al archivo
+ * cada STREAM_FLUSH_BYTES, así la memoria queda acotada por la función más
+ * grande y no por el programa. La sección de datos va al final.
+ */
+#define STREAM_FLUSH_BYTES (64 * 1024)
+
+/* a dónde va el assembly, para los mensajes de error */
+static const char* output_name(Compilation* c) {
+    return c->output ? c->output : "pipe al ensamblador";
+}
+
+static int stream_begin(Compilation* c) {
+    if (c->output) {
+        c->out_fd = open(c->output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (c->out_fd < 0) {
+            fprintf(c->diag, "%s: %s\n", c->output, strerror(errno));
+            return -1;
+        }
+    }
+    c->stream_mark = ast_mark(&c->ast);
+    gen_asm_begin(c, &c->asm_text);
+    return 0;
+}
+
+static void stream_flush(Compilation* c, size_t threshold) {
+    if (c->out_fd < 0 || c->asm_text.len < threshold) return;
+    if (asmbuf_flush_fd(&c->asm_text, c->out_fd) != 0 && c->result == 0) {
+        fprintf(c->diag, "%s: %s\n", output_name(c), strerror(errno));
+        c->result = 1;
+    }
+}
+
+int compile_toplevel(Compilation* c, ASTNode* decl) {
+    /* después de un error ya no se genera código */
+    if (!decl || decl->type == NODE_EXTERN_FUNC || c->result != 0) return 0;
+
+    phase_enter(&c->report, PHASE_FOLD);
+    if (c->opt_level >= 1)
+        decl = fold_constants(&c->ast, decl);
+    phase_leave(&c->report);
+
+    phase_enter(&c->report, PHASE_TAC);
+    TacList* code = gen_code(c, decl);
+    phase_leave(&c->report);
+    phase_count(&c->report, PHASE_TAC, code->count);
+
+    /* una global solo aporta su nombre a la sección de datos */
+    phase_enter(&c->report, PHASE_ASM);
+    size_t before = c->asm_text.len;
+    gen_asm_func(c, code, &c->asm_text);
+    phase_count(&c->report, PHASE_ASM, c->asm_text.len - before);
+    stream_flush(c, STREAM_FLUSH_BYTES);
+    phase_leave(&c->report);
+    free_tac(code);
+
+    if (decl->type != NODE_FUNC) return 0;
+    /* de la función solo queda la firma */
+    FuncInfo* f = find_function(c->funcs, decl->id);
+    if (f && f->node == decl) f->node = NULL;
+    ast_reset(&c->ast, c->stream_mark);
+    return 1;
+}
+
+static int stream_end(Compilation* c) {
+    if (c->root && c->result == 0) {
+        fprintf(c->out, "\n=== GENERACIÓN DE CÓDIGO INTERMEDIO ===\n");
+        gen_asm_end(c, &c->asm_text);
+        stream_flush(c, 0);
+    } else {
+        gen_asm_discard(c);
+        if (!c->root) fprintf(c->out, "No se generó AST raíz.\n");
+    }
+    phase_count(&c->report, PHASE_FOLD, c->ast.folded_count);
+    /* un descriptor que puso el llamador lo cierra él */
+    if (c->output && c->out_fd >= 0) {
+        close(c->out_fd);
+        c->out_fd = -1;
+        /* como sin streaming: si la compilación falló no queda un .s a medias */
+        if (!c->root || c->result != 0) unlink(c->output);
+        asmbuf_free(&c->asm_text);
+    }
+    return c->result;
+}
+
+/* vuelca asm_text a out_fd o a output (si hay) y lo libera */
+static void write_output(Compilation* c) {
+    phase_count(&c->report, PHASE_ASM, c->asm_text.len);
+    if (c->out_fd < 0 && !c->output) return;
+    int err = c->out_fd >= 0 ? asmbuf_flush_fd(&c->asm_text, c->out_fd)
+                             : asmbuf_write_file(&c->asm_text, c->output);
+    if (err) {
+        fprintf(c->diag, "%s: %s\n", output_name(c), strerror(errno));
+        c->result = 1;
+    }
+    asmbuf_free(&c->asm_text);
+}
+
+int compile(Compilation* c) {
+    FILE* in = c->in;
+    if (c->input) {
+        in = fopen(c->input, "r");
+        if (!in) {
+            fprintf(c->diag, "%s: %s\n", c->input, strerror(errno));
+            return c->result = 1;
+        }
+    }
+    if (c->streaming && stream_begin(c) != 0) {
+        if (c->input) fclose(in);
+        return c->result = 1;
+    }
+
+    yyscan_t scanner;
+    if (yylex_init_extra(c, &scanner) != 0) {
+        fprintf(c->diag, "Error: no se pudo crear el scanner\n");
+        if (c->input) fclose(in);
+        return c->result = 1;
+    }
+    yyset_in(in, scanner);
+
+    phase_enter(&c->report, PHASE_PARSE);
+    int parsed = yyparse(scanner, c);
+    if (parsed != 0) c->result = parsed;
+    phase_leave(&c->report);
+    phase_count(&c->report, PHASE_PARSE, c->ast.node_count);
+    yylex_destroy(scanner);
+    if (c->input) fclose(in);
+
+    if (c->streaming) return stream_end(c);
+
+    /* --- Generar código intermedio --- */
+    /* con errores semánticos no se escribe el .s ni se ensambla nada */
+    if (c->root && c->result == 0) {
+        phase_enter(&c->report, PHASE_FOLD);
+        if (c->opt_level >= 1)
+            c->root = fold_constants(&c->ast, c->root);
+        phase_leave(&c->report);
+        phase_count(&c->report, PHASE_FOLD, c->ast.folded_count);
+        fprintf(c->out, "\n=== GENERACIÓN DE CÓDIGO INTERMEDIO ===\n");
+        /* el texto se arma en memoria y va al archivo con una sola escritura */
+        if (c->cache_dir) {
+            /* TAC y assembly solo de las funciones que no están en la caché */
+            phase_enter(&c->report, PHASE_ASM);
+            cache_codegen(c, c->root, &c->asm_text);
+            write_output(c);
+            phase_leave(&c->report);
+            fprintf(c->out, "Caché: %ld aciertos, %ld fallos\n", c->cache_hits, c->cache_misses);
+        } else {
+            phase_enter(&c->report, PHASE_TAC);
+            TacList* code = gen_code(c, c->root);
+            phase_leave(&c->report);
+            phase_count(&c->report, PHASE_TAC, code->count);
+            phase_enter(&c->report, PHASE_ASM);
+            gen_asm(c, code, &c->asm_text);
+            write_output(c);
+            phase_leave(&c->report);
+            /*print_tac(code); Imprime el código intermedio*/
+            free_tac(code);
+        }
+    } else if (!c->root) {
+        fprintf(c->out, "No se generó AST raíz.\n");
+    }
+    return c->result;
+}
+
+void compilation_free(Compilation* c) {
+    while (c->current_scope) {          // normalmente solo queda el raíz
+        Scope* parent = c->current_scope->parent;
+        free_scope(c->current_scope);
+        c->current_scope = parent;
+    }
+    ast_release(&c->ast);               // libera nodos e hijos de una vez
+    free_functable(c->funcs);
+    c->funcs = NULL;
+    intern_release(&c->strings);
+    asmbuf_free(&c->asm_text);
+    gen_asm_discard(c);
+}
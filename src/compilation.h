@@ -0,0 +1,80 @@
+#ifndef COMPILATION_H
+#define COMPILATION_H
+#include <stdio.h>
+#include "ast.h"
+#include "intern.h"
+#include "symtable.h"
+#include "functable.h"
+#include "timereport.h"
+#include "asmbuf.h"
+
+/* Contadores de la generación de código. En serie hay uno para toda la
+   compilación; en paralelo cada función usa el suyo y después se corren
+   las etiquetas para que la numeración quede igual que en serie. */
+typedef struct GenCounters {
+    int temp_count;             // temporales (se reinicia en cada función)
+    int label_count;            // etiquetas del TAC
+    int asm_label_count;        // etiquetas propias del assembly
+} GenCounters;
+
+/* ---------- Contexto de una compilación ----------
+ * Todo el estado de compilar un archivo: memoria, tablas, contadores y
+ * salidas. No hay estado global, así que varias compilaciones pueden
+ * correr a la vez en hilos distintos (una por hilo).
+ */
+typedef struct Compilation {
+    const char *input;          // archivo fuente (NULL: se lee de in)
+    const char *output;         // archivo .s a generar (NULL: queda en asm_text)
+    int opt_level;              // -O0: sin plegado ni registros; -O2: además SSA
+    int codegen_threads;        // >1: TAC y asm de cada función en paralelo
+    int streaming;              // -fstream: cada función se compila y libera al reducirse
+    const char *cache_dir;      // -fcache: caché de assembly por función (NULL: sin caché)
+
+    FILE *in;                   // fuente si input es NULL (stdin)
+    FILE *diag;                 // errores y reportes (stderr o un buffer propio)
+    FILE *out;                  // mensajes informativos (stdout o un buffer propio)
+
+    /* memoria */
+    AstPool ast;
+    Interner strings;
+
+    /* análisis */
+    Scope *current_scope;
+    ASTNode *root;
+    FuncTable *funcs;
+    VarType current_return_type;    // usado para chequeo de return
+
+    GenCounters gen;            // generación de código
+    AsmBuf asm_text;            // assembly generado, si output es NULL
+
+    /* modo streaming */
+    ArenaMark stream_mark;      // fin de lo que se conserva del AST
+    int out_fd;                 // .s abierto mientras se parsea, o el pipe al
+                                // ensamblador que puso el llamador (-1: ninguno)
+    struct AsmGlobals *asm_globals;     // globales vistas por gen_asm_func
+
+    long cache_hits;            // funciones copiadas de la caché
+    long cache_misses;          // funciones generadas (y guardadas)
+
+    TimeReport report;
+    int result;                 // 0 si no hubo errores de sintaxis, semánticos ni de E/S
+} Compilation;
+
+/* deja c listo para compilar input en output; in/diag/out quedan en
+   stdin/stderr/stdout hasta que el llamador los cambie. Con output NULL no se
+   escribe ningún archivo: el texto queda en c->asm_text (asmbuf_take lo
+   entrega), para usar el compilador embebido sin archivos temporales, o
+   va a c->out_fd si el llamador puso ahí un descriptor (no lo cierra). */
+void compilation_init(Compilation* c, const char* input, const char* output);
+/* corre todas las fases; devuelve c->result */
+int compile(Compilation* c);
+/* Modo streaming: el parser entrega cada declaración de primer nivel apenas
+   se reduce. Las funciones se pliegan, se bajan a TAC y assembly y su AST
+   se libera (devuelve 1: no hay que guardarla en el programa); las
+   globales y las extern se conservan (devuelve 0). */
+int compile_toplevel(Compilation* c, ASTNode* decl);
+
+/* libera la memoria de la compilación (no cierra diag/out) */
+void compilation_free(Compilation* c);
+
+#endif
@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include "driver.h"
+#include "compilation.h"
+#include "parallel.h"
+#include "toolchain.h"
+
+static void usage(FILE* err, const char* prog) {
+    fprintf(err, "Uso: %s [-O|-O0|-O1|-O2] [-j N] [-fparallel-codegen[=N]] [-fstream] [-fcache[=dir]] [-ftime-report] [-ftime-report-json=<archivo>] [-o ejecutable] [entrada.c ...] [runtime.o ...]\n", prog);
+}
+
+/* Con varias entradas cada una se compila a <nombre>.s en el directorio
+   actual; "dir/prog.c" -> "prog.s" */
+static char* output_name(const char* input) {
+    const char* base = strrchr(input, '/');
+    base = base ? base + 1 : input;
+    size_t len = strlen(base);
+    if (len > 2 && strcmp(base + len - 2, ".c") == 0) len -= 2;
+    char* name = malloc(len + 3);
+    memcpy(name, base, len);
+    memcpy(name + len, ".s", 3);
+    return name;
+}
+
+/* Con -o cada entrada tiene su objeto y no se escribe ningún .s */
+static int is_object(const char* path) {
+    size_t len = strlen(path);
+    return (len > 2 && (strcmp(path + len - 2, ".o") == 0 || strcmp(path + len - 2, ".a") == 0)) ||
+           (len > 3 && strcmp(path + len - 3, ".so") == 0);
+}
+
+typedef struct Build {
+    Compilation* units;
+    char** objects;     // con -o: el objeto de cada entrada (NULL: se escribe el .s)
+    int err_fd;         // stderr de as y cc
+} Build;
+
+static void compile_unit(void* arg, int i) {
+    Build* b = arg;
+    Compilation* c = &b->units[i];
+    if (!b->objects) {
+        compile(c);
+        return;
+    }
+    /* el ensamblador lee del pipe mientras se compila esta entrada y las demás */
+    pid_t as = assembler_start(b->objects[i], b->err_fd, c->diag, &c->out_fd);
+    if (as < 0) {
+        c->result = 1;
+        return;
+    }
+    compile(c);
+    close(c->out_fd);
+    c->out_fd = -1;
+    if (tool_wait(as, "as", c->diag) != 0 && c->result == 0) c->result = 1;
+}
+
+/* Buffers en memoria para los mensajes de una compilación: con varios hilos
+   se vuelcan al final, en el orden de la línea de comandos */
+typedef struct {
+    char* diag_buf; size_t diag_len;
+    char* out_buf;  size_t out_len;
+} UnitLog;
+
+int calc_main(int argc, char** argv, FILE* in, FILE* out, FILE* err) {
+    const char** inputs = malloc(sizeof(char*) * argc);
+    int ninputs = 0;
+    const char** link_inputs = malloc(sizeof(char*) * argc);   // runtime y otros objetos
+    int nlink = 0;
+    const char* exe = NULL;         // -o: ejecutable en lugar de .s
+    const char* json_path = NULL;   // "-" = out
+    int print_report = 0;
+    int opt_level = 1;              // -O0: sin plegado de constantes; -O2: SSA
+    int jobs = 0;                   // 0 = un hilo por procesador
+    int codegen_threads = 0;        // -fparallel-codegen (0: no se pidió)
+    int streaming = 0;              // -fstream
+    const char* cache_dir = NULL;   // -fcache
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-' && argv[i][1] == 'O') {
+            /* -O sin número es -O1 */
+            const char* lvl = argv[i] + 2;
+            if (lvl[0] && (lvl[0] < '0' || lvl[0] > '2' || lvl[1])) {
+                usage(err, argv[0]);
+                free(link_inputs);
+                free(inputs);
+                return 1;
+            }
+            opt_level = lvl[0] ? lvl[0] - '0' : 1;
+        } else if (argv[i][0] == '-' && argv[i][1] == 'j') {
+            const char* n = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : "");
+            jobs = atoi(n);
+            if (jobs < 1) {
+                usage(err, argv[0]);
+                free(link_inputs);
+                free(inputs);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "-fparallel-codegen", 18) == 0 &&
+                   (argv[i][18] == '\0' || argv[i][18] == '=')) {
+            codegen_threads = argv[i][18] ? atoi(argv[i] + 19) : online_cpus();
+            if (codegen_threads < 1) {
+                usage(err, argv[0]);
+                free(link_inputs);
+                free(inputs);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-fstream") == 0) {
+            streaming = 1;
+        } else if (strncmp(argv[i], "-fcache", 7) == 0 &&
+                   (argv[i][7] == '\0' || argv[i][7] == '=')) {
+            cache_dir = argv[i][7] ? argv[i] + 8 : ".calc-cache";
+            if (!*cache_dir) {
+                usage(err, argv[0]);
+                free(link_inputs);
+                free(inputs);
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] == 'o') {
+            exe = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+            if (!exe) {
+                usage(err, argv[0]);
+                free(link_inputs);
+                free(inputs);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-ftime-report") == 0) {
+            print_report = 1;
+        } else if (strncmp(argv[i], "-ftime-report-json=", 19) == 0) {
+            json_path = argv[i] + 19;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(err, argv[0]);
+            free(link_inputs);
+            free(inputs);
+            return 1;
+        } else if (is_object(argv[i])) {
+            link_inputs[nlink++] = argv[i];
+        } else {
+            inputs[ninputs++] = argv[i];
+        }
+    }
+    if (streaming && cache_dir) {
+        fprintf(err, "Error: -fstream no se combina con -fcache\n");
+        usage(err, argv[0]);
+        free(link_inputs);
+        free(inputs);
+        return 1;
+    }
+    /* en streaming cada función se genera apenas se parsea, siempre en serie */
+    if (streaming && codegen_threads) {
+        fprintf(err, "Error: -fstream no se combina con -fparallel-codegen\n");
+        usage(err, argv[0]);
+        free(link_inputs);
+        free(inputs);
+        return 1;
+    }
+    if (nlink > 0 && !exe) {
+        fprintf(err, "Error: '%s' solo se usa al enlazar con -o\n", link_inputs[0]);
+        free(link_inputs);
+        free(inputs);
+        return 1;
+    }
+
+    /* una sola entrada (o in): out.s y mensajes directo a err/out */
+    int multi = ninputs > 1;
+    int count = multi ? ninputs : 1;
+    char** outputs = calloc(count, sizeof(char*));
+    for (int i = 0; exe == NULL && i < count; i++) {
+        outputs[i] = multi ? output_name(inputs[i]) : strdup("out.s");
+        for (int j = 0; j < i; j++) {
+            if (strcmp(outputs[j], outputs[i]) == 0) {
+                fprintf(err, "Error: '%s' y '%s' generarían el mismo %s\n",
+                        inputs[j], inputs[i], outputs[i]);
+                for (int k = 0; k <= i; k++) free(outputs[k]);
+                free(outputs);
+                free(link_inputs);
+                free(inputs);
+                return 1;
+            }
+        }
+    }
+
+    Build build = { NULL, NULL, fileno(err) };
+    char tmpdir[4096];
+    if (exe) {
+        /* los objetos viven solo hasta el enlace */
+        const char* t = getenv("TMPDIR");
+        snprintf(tmpdir, sizeof(tmpdir), "%s/calc-XXXXXX", t && *t ? t : "/tmp");
+        if (!mkdtemp(tmpdir)) {
+            fprintf(err, "%s: %s\n", tmpdir, strerror(errno));
+            free(outputs);
+            free(link_inputs);
+            free(inputs);
+            return 1;
+        }
+        build.objects = calloc(count, sizeof(char*));
+        for (int i = 0; i < count; i++) {
+            build.objects[i] = malloc(strlen(tmpdir) + 16);
+            sprintf(build.objects[i], "%s/%d.o", tmpdir, i);
+        }
+        /* si el ensamblador falla, escribir en su pipe da EPIPE y no mata a calc */
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    Compilation* units = calloc(count, sizeof(Compilation));
+    build.units = units;
+    UnitLog* logs = calloc(count, sizeof(UnitLog));
+    for (int i = 0; i < count; i++) {
+        Compilation* c = &units[i];
+        compilation_init(c, ninputs ? inputs[i] : NULL, outputs[i]);
+        c->in = in;
+        c->opt_level = opt_level;
+        c->codegen_threads = codegen_threads ? codegen_threads : 1;
+        c->streaming = streaming;
+        c->cache_dir = cache_dir;
+        c->report.enabled = print_report || json_path;
+        if (multi) {
+            c->diag = open_memstream(&logs[i].diag_buf, &logs[i].diag_len);
+            c->out = open_memstream(&logs[i].out_buf, &logs[i].out_len);
+        } else {
+            c->diag = err;
+            c->out = out;
+        }
+    }
+
+    parallel_for(count, jobs ? jobs : online_cpus(), compile_unit, &build);
+
+    int status = 0;
+    for (int i = 0; i < count; i++) {
+        Compilation* c = &units[i];
+        if (multi) {
+            fclose(c->out);
+            fclose(c->diag);
+            fwrite(logs[i].out_buf, 1, logs[i].out_len, out);
+            fflush(out);
+            fwrite(logs[i].diag_buf, 1, logs[i].diag_len, err);
+            free(logs[i].out_buf);
+            free(logs[i].diag_buf);
+        }
+        if (print_report) {
+            if (multi) fprintf(err, "\n%s:", c->input);
+            time_report_print(&c->report, err);
+        }
+        if (c->result != 0) status = c->result;
+    }
+
+    if (exe) {
+        fflush(out);
+        if (status == 0 &&
+            link_executable(exe, build.objects, count, link_inputs, nlink, build.err_fd, err) != 0)
+            status = 1;
+        for (int i = 0; i < count; i++) {
+            unlink(build.objects[i]);
+            free(build.objects[i]);
+        }
+        rmdir(tmpdir);
+    }
+    free(build.objects);
+
+    if (json_path) {
+        FILE* jf = strcmp(json_path, "-") == 0 ? out : fopen(json_path, "w");
+        if (!jf) {
+            fprintf(err, "%s: %s\n", json_path, strerror(errno));
+        } else {
+            /* con varias entradas, un arreglo con un reporte por archivo */
+            if (multi) fprintf(jf, "[\n");
+            for (int i = 0; i < count; i++) {
+                if (i > 0) fprintf(jf, ",\n");
+                time_report_json(&units[i].report, jf, units[i].input);
+            }
+            if (multi) fprintf(jf, "]\n");
+            if (jf != out) fclose(jf);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        compilation_free(&units[i]);
+        free(outputs[i]);
+    }
+    free(outputs);
+    free(units);
+    free(logs);
+    free(link_inputs);
+    free(inputs);
+    fflush(out);
+
+    return status;
+}
@@ -0,0 +1,11 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+#include <stdio.h>
+
+/* La línea de comandos de calc: interpreta argv, compila las entradas y
+   escribe los .s. Lo que el compilador leería de stdin o imprimiría en
+   stdout/stderr usa in/out/err, así el servidor puede atender a un
+   cliente con sus propios descriptores. Devuelve el código de salida. */
+int calc_main(int argc, char** argv, FILE* in, FILE* out, FILE* err);
+
+#endif
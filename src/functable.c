@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functable.h"
+#include "intern.h"
+
+#define FUNCTABLE_INITIAL_CAP 64
+
+static FuncInfo** find_slot(FuncTable* ft, const char* name) {
+    unsigned mask = ft->cap - 1;
+    unsigned i = intern_ptr_hash(name) & mask;
+    while (ft->slots[i] && ft->slots[i]->name != name)
+        i = (i + 1) & mask;
+    return &ft->slots[i];
+}
+
+static void grow_functable(FuncTable* ft) {
+    FuncInfo** old = ft->slots;
+    int old_cap = ft->cap;
+    ft->cap *= 2;
+    ft->slots = calloc(ft->cap, sizeof(FuncInfo*));
+    if (!ft->slots) { perror("calloc"); exit(1); }
+    for (int i = 0; i < old_cap; i++) {
+        if (old[i]) *find_slot(ft, old[i]->name) = old[i];
+    }
+    free(old);
+}
+
+FuncTable* create_functable(void) {
+    FuncTable* ft = malloc(sizeof(FuncTable));
+    if (!ft) { perror("malloc"); exit(1); }
+    ft->cap = FUNCTABLE_INITIAL_CAP;
+    ft->count = 0;
+    ft->slots = calloc(ft->cap, sizeof(FuncInfo*));
+    if (!ft->slots) { perror("calloc"); exit(1); }
+    return ft;
+}
+
+void free_functable(FuncTable* ft) {
+    if (!ft) return;
+    for (int i = 0; i < ft->cap; i++) {
+        if (!ft->slots[i]) continue;
+        free(ft->slots[i]->param_types);
+        free(ft->slots[i]);
+    }
+    free(ft->slots);
+    free(ft);
+}
+
+FuncInfo* add_function(FuncTable* ft, const char* name, VarType ret,
+                       VarType *param_types, int param_count, ASTNode* node) {
+    if ((ft->count + 1) * 2 > ft->cap) grow_functable(ft);
+    FuncInfo** slot = find_slot(ft, name);
+    if (*slot) return NULL;
+
+    FuncInfo* f = malloc(sizeof(FuncInfo));
+    if (!f) { perror("malloc"); exit(1); }
+    f->name = name;
+    f->ret_type = ret;
+    f->param_count = param_count;
+    f->param_types = param_types;
+    f->node = node;
+    *slot = f;
+    ft->count++;
+    return f;
+}
+
+FuncInfo* find_function(FuncTable* ft, const char* name) {
+    return *find_slot(ft, name);
+}
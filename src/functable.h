@@ -0,0 +1,31 @@
+#ifndef FUNCTABLE_H
+#define FUNCTABLE_H
+#include "ast.h"
+
+/* ---------- Registro de funciones ----------
+ * Firma y nodo del AST de cada función, indexados por nombre (internado).
+ * Se llena durante el parseo y lo usan el chequeo semántico y gen_asm.
+ */
+typedef struct FuncInfo {
+    const char *name;       /* internado */
+    VarType ret_type;
+    VarType *param_types;   /* array */
+    int param_count;
+    ASTNode *node;          /* NODE_FUNC o NODE_EXTERN_FUNC */
+} FuncInfo;
+
+typedef struct FuncTable {
+    FuncInfo **slots;       /* tabla hash (direccionamiento abierto) */
+    int cap;                /* potencia de 2 */
+    int count;
+} FuncTable;
+
+FuncTable* create_functable(void);
+void free_functable(FuncTable* ft);
+
+/* NULL si ya existe una función con ese nombre */
+FuncInfo* add_function(FuncTable* ft, const char* name, VarType ret,
+                       VarType *param_types, int param_count, ASTNode* node);
+FuncInfo* find_function(FuncTable* ft, const char* name);
+
+#endif
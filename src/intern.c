@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "intern.h"
+
+/* FNV-1a */
+static uint32_t hash_bytes(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void intern_grow(Interner* in) {
+    size_t new_cap = in->cap ? in->cap * 2 : 1024;
+    InternEntry* nt = calloc(new_cap, sizeof(InternEntry));
+    if (!nt) { perror("calloc"); exit(1); }
+    for (size_t i = 0; i < in->cap; i++) {
+        if (!in->table[i].str) continue;
+        size_t j = in->table[i].hash & (new_cap - 1);
+        while (nt[j].str) j = (j + 1) & (new_cap - 1);
+        nt[j] = in->table[i];
+    }
+    free(in->table);
+    in->table = nt;
+    in->cap = new_cap;
+}
+
+const char* intern_n(Interner* in, const char* s, size_t len) {
+    if (in->count * 2 >= in->cap) intern_grow(in);
+
+    uint32_t h = hash_bytes(s, len);
+    size_t i = h & (in->cap - 1);
+    while (in->table[i].str) {
+        if (in->table[i].hash == h && strncmp(in->table[i].str, s, len) == 0 &&
+            in->table[i].str[len] == '\0')
+            return in->table[i].str;
+        i = (i + 1) & (in->cap - 1);
+    }
+
+    char* copy = arena_alloc(&in->arena, len + 1);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    in->table[i].str = copy;
+    in->table[i].hash = h;
+    in->count++;
+    return copy;
+}
+
+const char* intern(Interner* in, const char* s) {
+    return intern_n(in, s, strlen(s));
+}
+
+void intern_release(Interner* in) {
+    free(in->table);
+    in->table = NULL;
+    in->cap = in->count = 0;
+    arena_free(&in->arena);
+}
@@ -0,0 +1,34 @@
+#ifndef INTERN_H
+#define INTERN_H
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+/* ---------- Tabla de cadenas internadas ----------
+ * Cada cadena distinta se guarda una sola vez; dos nombres internados son
+ * iguales si y solo si sus punteros son iguales. Cada compilación tiene su
+ * propia tabla (una Interner en cero está vacía y lista para usar).
+ */
+typedef struct InternEntry {
+    const char *str;    // NULL = vacío
+    uint32_t hash;
+} InternEntry;
+
+typedef struct Interner {
+    Arena arena;        // texto de las cadenas
+    InternEntry *table;
+    size_t cap;         // potencia de 2
+    size_t count;
+} Interner;
+
+const char* intern(Interner* in, const char* s);
+const char* intern_n(Interner* in, const char* s, size_t len);
+void intern_release(Interner* in);
+
+/* hash de un nombre internado (se hashea el puntero, no el texto) */
+static inline unsigned intern_ptr_hash(const char* s) {
+    uintptr_t p = (uintptr_t)s;
+    return (unsigned)((p >> 3) * 0x9E3779B97F4A7C15ull >> 32);
+}
+
+#endif
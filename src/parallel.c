@@ -0,0 +1,43 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "parallel.h"
+
+/* Cola compartida por los hilos: cada uno toma el siguiente índice libre
+   hasta agotarla */
+typedef struct WorkQueue {
+    int count;
+    int next;
+    void (*fn)(void* arg, int i);
+    void* arg;
+} WorkQueue;
+
+static void* worker(void* p) {
+    WorkQueue* q = p;
+    int i;
+    while ((i = __atomic_fetch_add(&q->next, 1, __ATOMIC_RELAXED)) < q->count)
+        q->fn(q->arg, i);
+    return NULL;
+}
+
+void parallel_for(int count, int threads, void (*fn)(void* arg, int i), void* arg) {
+    WorkQueue q = { count, 0, fn, arg };
+    if (threads > count) threads = count;
+    if (threads <= 1) {
+        worker(&q);
+        return;
+    }
+    pthread_t* ids = malloc(sizeof(pthread_t) * (threads - 1));
+    int started = 0;
+    while (started < threads - 1 && pthread_create(&ids[started], NULL, worker, &q) == 0)
+        started++;
+    worker(&q);
+    for (int i = 0; i < started; i++)
+        pthread_join(ids[i], NULL);
+    free(ids);
+}
+
+int online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
@@ -0,0 +1,17 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/* Llama fn(arg, i) para cada i en [0, count), repartiendo los índices
+   entre hasta threads hilos (incluido el que llama). Vuelve cuando
+   terminaron todos; el orden de ejecución no está definido. */
+void parallel_for(int count, int threads, void (*fn)(void* arg, int i), void* arg);
+
+/* Al repartir trabajo de tamaño desparejo (p.ej. funciones) conviene
+   armar unos pocos tramos por hilo: se balancea la carga sin pagar la
+   sobrecarga de una tarea por elemento. */
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+/* cantidad de procesadores disponibles (al menos 1) */
+int online_cpus(void);
+
+#endif
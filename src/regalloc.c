@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "regalloc.h"
+
+const char* const reg_name32[REG_COUNT] = {
+    [REG_R10] = "%r10d", [REG_R11] = "%r11d",
+    [REG_RBX] = "%ebx", [REG_R12] = "%r12d", [REG_R13] = "%r13d",
+    [REG_R14] = "%r14d", [REG_R15] = "%r15d",
+};
+
+const char* const reg_name64[REG_COUNT] = {
+    [REG_R10] = "%r10", [REG_R11] = "%r11",
+    [REG_RBX] = "%rbx", [REG_R12] = "%r12", [REG_R13] = "%r13",
+    [REG_R14] = "%r14", [REG_R15] = "%r15",
+};
+
+/* Tope de bits (bloques x valores vivos entre bloques) para el análisis de
+   vida; una función más grande que eso queda entera en memoria */
+#define REGALLOC_MAX_BITS (1L << 27)
+
+typedef struct Interval {
+    int start, end;         // posiciones de instrucción, inclusive
+    int value;
+    int crosses_call;       // hay un CALL estrictamente adentro
+    long long cost;         // lecturas y escrituras, pesadas por lazo
+} Interval;
+
+static void* xcalloc(size_t n, size_t size) {
+    void* p = calloc(n ? n : 1, size);
+    if (!p) { perror("calloc"); exit(1); }
+    return p;
+}
+
+static void extend(Interval* iv, int v, int pos) {
+    if (pos < iv[v].start) iv[v].start = pos;
+    if (pos > iv[v].end) iv[v].end = pos;
+}
+
+static int by_start(const void* a, const void* b) {
+    const Interval* x = a;
+    const Interval* y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return x->value - y->value;
+}
+
+/* Intervalos de vida: de cada lectura y escritura y, para los valores que
+   viven entre bloques, de la entrada y la salida de cada bloque donde
+   están vivos (análisis de vida clásico, hacia atrás, con bitsets). Un
+   valor que sigue vivo al salir de un bloque se extiende hasta la primera
+   posición siguiente, así no comparte registro con lo que escribe la
+   última instrucción del bloque. Devuelve 0 si la función es demasiado
+   grande para analizarla. */
+static int build_intervals(const CFG* g, int n, const int (*vals)[3],
+                           const int* use_pos, int nvalues, Interval* iv) {
+    // valores leídos en un bloque antes de escribirse en él: viven entre bloques
+    int* gid = malloc(sizeof(int) * nvalues);
+    int* stamp = malloc(sizeof(int) * nvalues);
+    if (!gid || !stamp) { perror("malloc"); exit(1); }
+    for (int v = 0; v < nvalues; v++) gid[v] = stamp[v] = -1;
+    int nglobal = 0;
+    for (int b = 0; b < g->nblocks; b++) {
+        for (int i = g->blocks[b].first; i < g->blocks[b].last; i++) {
+            for (int k = 0; k < 2; k++) {
+                int v = vals[i][k];
+                if (v >= 0 && stamp[v] != b && gid[v] < 0) gid[v] = nglobal++;
+            }
+            if (vals[i][2] >= 0) stamp[vals[i][2]] = b;
+        }
+    }
+
+    size_t words = (nglobal + 63) / 64;
+    if ((long)words * 64 * g->nblocks > REGALLOC_MAX_BITS) {
+        free(gid);
+        free(stamp);
+        return 0;
+    }
+
+    int* global_value = xcalloc(nglobal, sizeof(int));
+    for (int v = 0; v < nvalues; v++)
+        if (gid[v] >= 0) global_value[gid[v]] = v;
+
+    uint64_t* use = xcalloc(words * g->nblocks, sizeof(uint64_t));
+    uint64_t* def = xcalloc(words * g->nblocks, sizeof(uint64_t));
+    uint64_t* in = xcalloc(words * g->nblocks, sizeof(uint64_t));
+    uint64_t* out = xcalloc(words * g->nblocks, sizeof(uint64_t));
+#define BIT_SET(s, g)  ((s)[(g) >> 6] |= 1ULL << ((g) & 63))
+#define BIT_TEST(s, g) (((s)[(g) >> 6] >> ((g) & 63)) & 1)
+    for (int b = 0; b < g->nblocks; b++) {
+        uint64_t* u = use + b * words;
+        uint64_t* d = def + b * words;
+        for (int i = g->blocks[b].first; i < g->blocks[b].last; i++) {
+            for (int k = 0; k < 2; k++) {
+                int v = vals[i][k];
+                if (v >= 0 && gid[v] >= 0 && !BIT_TEST(d, gid[v])) BIT_SET(u, gid[v]);
+            }
+            int v = vals[i][2];
+            if (v >= 0 && gid[v] >= 0) BIT_SET(d, gid[v]);
+        }
+    }
+
+    // in = use | (out & ~def), out = unión de los in de los sucesores
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = g->nblocks - 1; b >= 0; b--) {
+            uint64_t* o = out + b * words;
+            uint64_t* ib = in + b * words;
+            for (int s = 0; s < 2; s++) {
+                int sb = g->blocks[b].succ[s];
+                if (sb < 0) continue;
+                uint64_t* is = in + sb * words;
+                for (size_t w = 0; w < words; w++) o[w] |= is[w];
+            }
+            uint64_t* u = use + b * words;
+            uint64_t* d = def + b * words;
+            for (size_t w = 0; w < words; w++) {
+                uint64_t x = u[w] | (o[w] & ~d[w]);
+                if (x != ib[w]) {
+                    ib[w] = x;
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 2; k++)
+            if (vals[i][k] >= 0) extend(iv, vals[i][k], use_pos[i]);
+        if (vals[i][2] >= 0) extend(iv, vals[i][2], i);
+    }
+    for (int b = 0; b < g->nblocks; b++) {
+        for (int x = 0; x < nglobal; x++) {
+            if (BIT_TEST(in + b * words, x)) extend(iv, global_value[x], g->blocks[b].first);
+            if (BIT_TEST(out + b * words, x)) extend(iv, global_value[x], g->blocks[b].last);
+        }
+    }
+#undef BIT_SET
+#undef BIT_TEST
+
+    free(use);
+    free(def);
+    free(in);
+    free(out);
+    free(global_value);
+    free(gid);
+    free(stamp);
+    return 1;
+}
+
+/* costo de dejar un valor en memoria: sus accesos, x8 por nivel de lazo */
+static long long access_weight(int depth) {
+    return 1LL << (3 * (depth < 8 ? depth : 8));
+}
+
+unsigned regalloc_function(const CFG* g, const int (*vals)[3],
+                           int nvalues, int nentry, signed char* reg) {
+    const TAC* code = g->code;
+    int n = g->ninstr;
+    for (int v = 0; v < nvalues; v++) reg[v] = REG_NONE;
+    if (n == 0 || nvalues == 0) return 0;
+
+    // los argumentos de un CALL se cargan en el CALL, no en sus PARAM
+    int* use_pos = malloc(sizeof(int) * n);
+    int* calls_before = malloc(sizeof(int) * (n + 2));
+    if (!use_pos || !calls_before) { perror("malloc"); exit(1); }
+    int next_call = n;
+    for (int i = n - 1; i >= 0; i--) {
+        if (code[i].op == TAC_CALL) next_call = i;
+        use_pos[i] = code[i].op == TAC_PARAM ? next_call : i;
+    }
+    calls_before[0] = 0;
+    for (int i = 0; i <= n; i++)
+        calls_before[i + 1] = calls_before[i] + (i < n && code[i].op == TAC_CALL);
+
+    Interval* iv = xcalloc(nvalues, sizeof(Interval));
+    for (int v = 0; v < nvalues; v++) {
+        iv[v].start = INT_MAX;
+        iv[v].end = -1;
+        iv[v].value = v;
+    }
+    int ok = build_intervals(g, n, vals, use_pos, nvalues, iv);
+    for (int i = 0; ok && i < n; i++) {
+        long long w = access_weight(g->blocks[g->block_of[i]].loop_depth);
+        for (int k = 0; k < 3; k++)
+            if (vals[i][k] >= 0) iv[vals[i][k]].cost += w;
+    }
+    // un parámetro que se lee llega vivo desde antes de la primera
+    // instrucción (posición -1): no comparte registro con otro parámetro
+    for (int v = 0; ok && v < nentry && v < nvalues; v++)
+        if (iv[v].end >= 0) extend(iv, v, -1);
+
+    // solo los valores que se usan; por orden de comienzo
+    int count = 0;
+    for (int v = 0; ok && v < nvalues; v++) {
+        if (iv[v].end < 0) continue;
+        Interval* x = &iv[count++];
+        *x = iv[v];
+        x->crosses_call = calls_before[x->end] - calls_before[x->start + 1] > 0;
+    }
+    qsort(iv, count, sizeof(Interval), by_start);
+
+    unsigned used = 0;
+    int owner[REG_COUNT];       // intervalo que ocupa cada registro (-1: libre)
+    for (int r = 0; r < REG_COUNT; r++) owner[r] = -1;
+    for (int k = 0; k < count; k++) {
+        Interval* cur = &iv[k];
+        // un registro se libera en la última lectura: cada instrucción lee
+        // sus operandos antes de escribir el resultado
+        for (int r = 0; r < REG_COUNT; r++)
+            if (owner[r] >= 0 && iv[owner[r]].end <= cur->start) owner[r] = -1;
+
+        // lo que cruza un CALL solo puede ir a un callee-saved; entre esos,
+        // primero los que la función ya guarda
+        int pick = -1;
+        for (int r = 0; pick < 0 && r < REG_COUNT; r++)
+            if (owner[r] < 0 && !REG_CALLEE_SAVED(r) && !cur->crosses_call) pick = r;
+        for (int r = 0; pick < 0 && r < REG_COUNT; r++)
+            if (owner[r] < 0 && REG_CALLEE_SAVED(r) && (used & (1u << r))) pick = r;
+        for (int r = 0; pick < 0 && r < REG_COUNT; r++)
+            if (owner[r] < 0 && REG_CALLEE_SAVED(r)) pick = r;
+
+        if (pick < 0) {
+            // sin lugar: va a memoria el que menos se usa (a igual costo,
+            // el que termina más tarde), sea uno activo o el nuevo
+            int victim = -1;
+            for (int r = 0; r < REG_COUNT; r++) {
+                if (cur->crosses_call && !REG_CALLEE_SAVED(r)) continue;
+                const Interval* x = &iv[owner[r]];
+                if (victim < 0 || x->cost < iv[owner[victim]].cost ||
+                    (x->cost == iv[owner[victim]].cost && x->end > iv[owner[victim]].end))
+                    victim = r;
+            }
+            if (victim < 0) continue;
+            const Interval* x = &iv[owner[victim]];
+            if (x->cost > cur->cost || (x->cost == cur->cost && x->end <= cur->end)) continue;
+            reg[iv[owner[victim]].value] = REG_NONE;
+            pick = victim;
+        }
+        owner[pick] = k;
+        reg[cur->value] = pick;
+        if (REG_CALLEE_SAVED(pick)) used |= 1u << pick;
+    }
+
+    free(iv);
+    free(use_pos);
+    free(calls_before);
+    return used;
+}
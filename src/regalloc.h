@@ -0,0 +1,34 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+#include "cfg.h"
+
+/* ---------- Asignación de registros ----------
+ * Linear scan sobre intervalos de vida, una función a la vez. Los valores
+ * son los temporales y las variables propias de la función (parámetros y
+ * locales); las globales quedan siempre en memoria. %eax, %ecx y %edx son
+ * de uso interno del generador (resultados, divisor, idiv) y los registros
+ * de argumentos no se reparten, así cargar los argumentos de un CALL nunca
+ * pisa un valor vivo.
+ */
+typedef enum {
+    REG_R10, REG_R11,                               // caller-saved
+    REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15,    // callee-saved
+    REG_COUNT
+} Reg;
+
+#define REG_NONE (-1)
+#define REG_CALLEE_SAVED(r) ((r) >= REG_RBX)
+
+extern const char* const reg_name32[REG_COUNT];
+extern const char* const reg_name64[REG_COUNT];
+
+/* Reparte registros entre nvalues valores de la región del grafo g.
+   vals[i] son los valores que lee la instrucción i (0 y 1) y el que
+   escribe (2), o -1. Los valores 0..nentry-1 (los parámetros) llegan
+   definidos a la entrada. Deja en reg[v] el registro de cada valor o
+   REG_NONE si va a memoria y devuelve la máscara de registros
+   callee-saved usados (bit r). */
+unsigned regalloc_function(const CFG* g, const int (*vals)[3],
+                           int nvalues, int nentry, signed char* reg);
+
+#endif
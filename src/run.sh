@@ -8,7 +8,8 @@ flex calc-lexico.l
 bison -d calc-sintaxis.y
 
 # Compilar con GCC
-gcc -o calc calc-sintaxis.tab.c lex.yy.c ast.c symtable.c codegen.c codegen_asm.c -lfl
+gcc -o calc calc-sintaxis.tab.c lex.yy.c arena.c intern.c ast.c symtable.c functable.c codegen.c codegen_asm.c asmbuf.c cache.c cfg.c compilation.c driver.c parallel.c regalloc.c server.c ssa.c timereport.c toolchain.c -lfl -lpthread
+gcc -o calcc client.c
 
 
 # Ejecutar tests
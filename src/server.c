@@ -0,0 +1,212 @@
+#define _GNU_SOURCE     /* accept4 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+#include "driver.h"
+
+/* Los pedidos se atienden de a uno: el directorio actual es del proceso y
+   cada pedido se para en el del cliente. Dentro de un pedido calc_main
+   puede usar varios hilos (-j, -fparallel-codegen) igual que calc. */
+
+static char socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+static void stop_server(int sig) {
+    (void)sig;
+    unlink(socket_path);
+    _exit(0);
+}
+
+static int read_full(int fd, void* buf, size_t n) {
+    char* p = buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+/* Recibe el encabezado y los tres descriptores del cliente */
+static int recv_request(int conn, ServerRequest* req, int fds[3]) {
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov = { req, sizeof(*req) };
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t r;
+    do {
+        r = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+    } while (r < 0 && errno == EINTR);
+    if (r <= 0) return -1;
+    /* con MSG_CTRUNC el kernel ya cerró los descriptores que no entraron */
+    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    size_t nfds = 0;
+    if (cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+        nfds = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    if (nfds != 3 || (msg.msg_flags & MSG_CTRUNC) || r != (ssize_t)sizeof(*req)) {
+        for (size_t i = 0; i < nfds; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            close(fd);
+        }
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cm), 3 * sizeof(int));
+    return 0;
+}
+
+/* Un pedido completo; devuelve el código de salida para el cliente */
+static int32_t handle_request(int conn, int home) {
+    ServerRequest req;
+    int fds[3];
+    if (recv_request(conn, &req, fds) != 0) return -1;
+
+    int32_t status = 1;
+    char* payload = NULL;
+    char** argv = NULL;
+    FILE* in = fdopen(fds[0], "r");
+    FILE* out = fdopen(fds[1], "w");
+    FILE* err = fdopen(fds[2], "w");
+    if (!in || !out || !err) goto done;
+    /* como en un proceso nuevo: stderr sin buffer, stdout por líneas en una terminal */
+    setvbuf(err, NULL, _IONBF, 0);
+    if (isatty(fds[1])) setvbuf(out, NULL, _IOLBF, 0);
+
+    if (req.argc == 0 || req.payload_len == 0 || req.payload_len > SERVER_MAX_PAYLOAD ||
+        req.argc > req.payload_len) {
+        fprintf(err, "calc: pedido inválido\n");
+        goto done;
+    }
+    payload = malloc(req.payload_len);
+    argv = calloc(req.argc + 1, sizeof(char*));
+    if (read_full(conn, payload, req.payload_len) != 0 ||
+        payload[req.payload_len - 1] != '\0') {
+        fprintf(err, "calc: pedido inválido\n");
+        goto done;
+    }
+    /* payload: cwd, argv[0], ..., argv[argc-1] */
+    char* p = payload;
+    char* end = payload + req.payload_len;
+    const char* cwd = p;
+    p += strlen(p) + 1;
+    for (uint32_t i = 0; i < req.argc; i++) {
+        if (p >= end) {
+            fprintf(err, "calc: pedido inválido\n");
+            goto done;
+        }
+        argv[i] = p;
+        p += strlen(p) + 1;
+    }
+
+    if (chdir(cwd) != 0) {
+        fprintf(err, "calc: %s: %s\n", cwd, strerror(errno));
+        goto done;
+    }
+    status = calc_main((int)req.argc, argv, in, out, err);
+    if (fchdir(home) != 0) perror("calc: fchdir");
+
+done:
+    /* los descriptores son copias: cerrarlos no afecta al cliente */
+    if (in) fclose(in); else close(fds[0]);
+    if (out) fclose(out); else close(fds[1]);
+    if (err) fclose(err); else close(fds[2]);
+    free(argv);
+    free(payload);
+    return status;
+}
+
+int serve(const char* path) {
+    char def[sizeof(socket_path)];
+    if (!path && !(path = calc_socket_path(def, sizeof(def), 1))) {
+        fprintf(stderr, "calc: directorio del socket: %s\n", strerror(errno));
+        return 1;
+    }
+    if (strlen(path) >= sizeof(socket_path)) {
+        fprintf(stderr, "calc: ruta de socket demasiado larga: %s\n", path);
+        return 1;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("calc: socket");
+        return 1;
+    }
+    /* un socket que nadie atiende quedó de un servidor anterior */
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "calc: ya hay un servidor en %s\n", path);
+        close(fd);
+        return 1;
+    }
+    /* solo se reemplaza un socket propio, nunca un archivo cualquiera */
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode) || st.st_uid != getuid()) {
+            fprintf(stderr, "calc: %s existe y no es un socket propio\n", path);
+            close(fd);
+            return 1;
+        }
+        unlink(path);
+    }
+    /* el socket nace sin permisos para otros usuarios */
+    mode_t old_mask = umask(077);
+    int bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old_mask);
+    if (bound != 0 || listen(fd, 16) != 0) {
+        fprintf(stderr, "calc: %s: %s\n", path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    /* para borrarlo al salir aunque el pedido en curso haya cambiado de directorio */
+    if (path[0] == '/' || !getcwd(socket_path, sizeof(socket_path)) ||
+        strlen(socket_path) + 1 + strlen(path) >= sizeof(socket_path))
+        strcpy(socket_path, path);
+    else
+        strcat(strcat(socket_path, "/"), path);
+    signal(SIGINT, stop_server);
+    signal(SIGTERM, stop_server);
+    /* un cliente que se va a mitad de pedido no debe tirar el servidor */
+    signal(SIGPIPE, SIG_IGN);
+    int home = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    fprintf(stderr, "calc: escuchando en %s\n", path);
+
+    for (;;) {
+        int conn = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("calc: accept");
+            break;
+        }
+        if (!calc_peer_is_self(conn)) {
+            close(conn);
+            continue;
+        }
+        int32_t status = handle_request(conn, home);
+        if (status >= 0) {
+            ssize_t w = write(conn, &status, sizeof(status));
+            (void)w;
+        }
+        close(conn);
+    }
+    close(home);
+    close(fd);
+    unlink(path);
+    return 1;
+}
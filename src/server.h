@@ -0,0 +1,77 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+/* ---------- Servidor de compilación ----------
+ * `calc -fserver[=socket]` deja el compilador residente y atiende pedidos
+ * por un socket Unix; `calcc` (client.c) es el cliente y acepta la misma
+ * línea de comandos que calc. Un pedido es:
+ *
+ *   ServerRequest + descriptores stdin/stdout/stderr del cliente (SCM_RIGHTS)
+ *   payload: directorio actual del cliente y argv, terminados en '\0'
+ *
+ * El servidor se para en ese directorio, corre calc_main con los
+ * descriptores del cliente (así mensajes, reportes y lecturas de stdin van
+ * directo a él) y responde el código de salida como un int32_t. Los .s se
+ * escriben en el directorio del cliente igual que con calc.
+ *
+ * El servidor recibe los descriptores y el directorio de quien se conecta,
+ * así que servidor y cliente solo hablan con procesos del mismo usuario
+ * (SO_PEERCRED). El socket por defecto vive en un directorio que solo ese
+ * usuario puede escribir.
+ */
+
+#define CALC_SOCKET_ENV "CALC_SOCKET"
+#define SERVER_MAX_PAYLOAD (1 << 20)
+
+typedef struct ServerRequest {
+    uint32_t argc;
+    uint32_t payload_len;       // bytes que siguen al encabezado
+} ServerRequest;
+
+/* socket por defecto: $CALC_SOCKET o calc.sock en $XDG_RUNTIME_DIR o en
+   /tmp/calc-<uid>. El directorio tiene que ser del usuario, no un enlace y
+   sin permisos para nadie más; con create se crea si no existe. Devuelve
+   NULL con errno si el directorio no sirve. */
+static inline const char* calc_socket_path(char* buf, size_t n, int create) {
+    const char* env = getenv(CALC_SOCKET_ENV);
+    if (env && *env) return env;
+    const char* run = getenv("XDG_RUNTIME_DIR");
+    int len = run && *run ? snprintf(buf, n, "%s", run)
+                          : snprintf(buf, n, "/tmp/calc-%u", (unsigned)getuid());
+    if (len < 0 || (size_t)len + sizeof("/calc.sock") > n) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    if (create && mkdir(buf, 0700) != 0 && errno != EEXIST) return NULL;
+    struct stat st;
+    if (lstat(buf, &st) != 0) return NULL;
+    if (!S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077)) {
+        errno = EPERM;
+        return NULL;
+    }
+    strcat(buf, "/calc.sock");
+    return buf;
+}
+
+/* el proceso del otro lado de la conexión es del mismo usuario
+   (struct ucred requiere _GNU_SOURCE) */
+static inline int calc_peer_is_self(int fd) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 &&
+           cred.uid == getuid();
+}
+
+/* atiende pedidos en path (NULL: el socket por defecto) hasta recibir
+   SIGINT o SIGTERM; devuelve el código de salida del proceso */
+int serve(const char* path);
+
+#endif
@@ -0,0 +1,1316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ssa.h"
+#include "cfg.h"
+
+/* Tope de phis por instrucción: más que eso y la función queda como está */
+#define SSA_MAX_PHIS_PER_INS 8
+
+/* Operando en SSA: un nombre o, si name < 0, el operando original
+   (inmediato, global, etiqueta, función o ninguno) */
+typedef struct Use {
+    int name;
+    Operand o;
+} Use;
+
+typedef struct Ins {
+    TacOp op;
+    Use a[2];
+    int res;                // nombre que escribe (-1: ninguno)
+    Operand raw_res;        // resultado si no es un valor propio
+    int block;
+    char gone;              // eliminada
+    char live;              // ADCE
+} Ins;
+
+typedef struct Phi {
+    int res;
+    int value;              // valor original
+    int block;
+    int next;               // siguiente phi del bloque (-1)
+    int args;               // en Ssa.args: uno por predecesor y, en la entrada, el valor inicial
+    char gone, live;
+} Phi;
+
+/* copia que sale de un phi: dst = src */
+typedef struct Copy {
+    int dst;
+    Use src;
+    int next;
+} Copy;
+
+typedef struct Ssa {
+    const CFG *g;
+    Ins *ins;
+    int n;
+    int nvalues, nvars;
+    const Operand *vars;
+
+    Phi *phis;
+    int nphis, capphis;
+    int *phi_head;          // por bloque
+    Use *args;
+    int nargs, capargs;
+
+    /* nombres: 0..nvalues-1 son los valores al entrar a la función */
+    int nnames, capnames;
+    int *name_value;
+    int *def_ins;
+    int *def_phi;
+    Use *repl;              // reemplazo tras SCCP/GVN (name -2: ninguno)
+
+    int *child_start;       // árbol de dominadores (CSR)
+    int *children;
+
+    /* SCCP */
+    char *block_exec;
+    char *edge_exec;        // por bloque, 2 sucesores
+} Ssa;
+
+#define NO_REPL (-2)
+
+static void* xcalloc(size_t n, size_t size) {
+    void* p = calloc(n ? n : 1, size);
+    if (!p) { perror("calloc"); exit(1); }
+    return p;
+}
+
+static void* xrealloc(void* p, size_t size) {
+    p = realloc(p, size ? size : 1);
+    if (!p) { perror("realloc"); exit(1); }
+    return p;
+}
+
+static Use use_name(int name) {
+    Use u = { .name = name };
+    return u;
+}
+
+static Use use_imm(int v) {
+    Use u = { .name = -1, .o = { .kind = OPND_IMM, .imm = v } };
+    return u;
+}
+
+static Use use_none(void) {
+    Use u = { .name = -1, .o = { .kind = OPND_NONE } };
+    return u;
+}
+
+static int is_none(Use u) {
+    return u.name < 0 && u.o.kind == OPND_NONE;
+}
+
+static int same_use(Use a, Use b) {
+    if (a.name >= 0 || b.name >= 0) return a.name == b.name;
+    return a.o.kind == OPND_IMM && b.o.kind == OPND_IMM && a.o.imm == b.o.imm;
+}
+
+static int new_name(Ssa* s, int value) {
+    if (s->nnames == s->capnames) {
+        s->capnames = s->capnames ? s->capnames * 2 : 64;
+        s->name_value = xrealloc(s->name_value, sizeof(int) * s->capnames);
+        s->def_ins = xrealloc(s->def_ins, sizeof(int) * s->capnames);
+        s->def_phi = xrealloc(s->def_phi, sizeof(int) * s->capnames);
+    }
+    int x = s->nnames++;
+    s->name_value[x] = value;
+    s->def_ins[x] = s->def_phi[x] = -1;
+    return x;
+}
+
+static int phi_nargs(const Ssa* s, int b) {
+    return s->g->blocks[b].npreds + (b == 0);
+}
+
+static Use* phi_args(const Ssa* s, const Phi* p) {
+    return &s->args[p->args];
+}
+
+static int add_phi(Ssa* s, int value, int b) {
+    if (s->nphis == s->capphis) {
+        s->capphis = s->capphis ? s->capphis * 2 : 64;
+        s->phis = xrealloc(s->phis, sizeof(Phi) * s->capphis);
+    }
+    int k = phi_nargs(s, b);
+    if (s->nargs + k > s->capargs) {
+        while (s->nargs + k > s->capargs) s->capargs = s->capargs ? s->capargs * 2 : 256;
+        s->args = xrealloc(s->args, sizeof(Use) * s->capargs);
+    }
+    Phi* p = &s->phis[s->nphis];
+    memset(p, 0, sizeof(*p));
+    p->value = value;
+    p->block = b;
+    p->res = -1;
+    p->args = s->nargs;
+    for (int j = 0; j < k; j++) s->args[s->nargs + j] = use_none();
+    s->nargs += k;
+    p->next = s->phi_head[b];
+    s->phi_head[b] = s->nphis;
+    return s->nphis++;
+}
+
+/* índice de p entre los predecesores de b */
+static int pred_index(const CFG* g, int b, int p) {
+    for (int j = 0; j < g->blocks[b].npreds; j++)
+        if (g->blocks[b].preds[j] == p) return j;
+    return -1;
+}
+
+/* ---------- Construcción ---------- */
+
+static void load_code(Ssa* s, const TAC* code, const int (*vals)[3]) {
+    s->ins = xcalloc(s->n, sizeof(Ins));
+    for (int i = 0; i < s->n; i++) {
+        Ins* in = &s->ins[i];
+        const TAC* t = &code[i];
+        in->op = t->op;
+        in->block = s->g->block_of[i];
+        in->a[0].name = vals[i][0];
+        in->a[0].o = t->arg1;
+        in->a[1].name = vals[i][1];
+        in->a[1].o = t->arg2;
+        in->res = vals[i][2];
+        in->raw_res = t->result;
+        // lo que no se alcanza desde la entrada no se ejecuta nunca
+        in->gone = s->g->blocks[in->block].rpo < 0;
+    }
+}
+
+/* Frontera de dominancia (Cooper, Harvey y Kennedy), en CSR */
+static void dominance_frontiers(const CFG* g, int** out_start, int** out_list) {
+    int nb = g->nblocks;
+    int* start = xcalloc(nb + 1, sizeof(int));
+    int* stamp = xcalloc(nb, sizeof(int));
+    int* list = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+        int* fill = pass ? xcalloc(nb, sizeof(int)) : NULL;
+        for (int b = 0; b < nb; b++) stamp[b] = -1;
+        for (int b = 0; b < nb; b++) {
+            const BasicBlock* bb = &g->blocks[b];
+            if (bb->rpo < 0 || bb->npreds + (b == 0) < 2) continue;
+            for (int j = 0; j < bb->npreds; j++) {
+                int r = bb->preds[j];
+                if (g->blocks[r].rpo < 0) continue;
+                while (r >= 0 && r != bb->idom) {
+                    if (stamp[r] != b) {
+                        stamp[r] = b;
+                        if (pass) list[start[r] + fill[r]++] = b;
+                        else start[r + 1]++;
+                    }
+                    r = g->blocks[r].idom;
+                }
+            }
+        }
+        if (!pass) {
+            for (int b = 0; b < nb; b++) start[b + 1] += start[b];
+            list = xcalloc(start[nb], sizeof(int));
+        }
+        free(fill);
+    }
+    free(stamp);
+    *out_start = start;
+    *out_list = list;
+}
+
+/* phis en la frontera de dominancia iterada de las definiciones, solo
+   para los valores leídos en algún bloque antes de escribirse en él (SSA
+   semi-podado). Todas las variables cuentan como definidas en la entrada.
+   Devuelve 0 si hay demasiados phis. */
+static int place_phis(Ssa* s) {
+    const CFG* g = s->g;
+    int nb = g->nblocks;
+    int nv = s->nvalues;
+    char* crosses = xcalloc(nv, 1);
+    int* stamp = xcalloc(nv, sizeof(int));
+    for (int v = 0; v < nv; v++) stamp[v] = -1;
+    for (int b = 0; b < nb; b++) {
+        if (g->blocks[b].rpo < 0) continue;
+        for (int i = g->blocks[b].first; i < g->blocks[b].last; i++) {
+            const Ins* in = &s->ins[i];
+            for (int k = 0; k < 2; k++)
+                if (in->a[k].name >= 0 && stamp[in->a[k].name] != b) crosses[in->a[k].name] = 1;
+            if (in->res >= 0) stamp[in->res] = b;
+        }
+    }
+
+    // bloques que definen cada valor, sin repetir (CSR: los de v están en
+    // defblocks[dstart[v], dstart[v + 1]))
+    int* dstart = xcalloc(nv + 1, sizeof(int));
+    int* defblocks = NULL;
+    int* fill = xcalloc(nv, sizeof(int));
+    for (int pass = 0; pass < 2; pass++) {
+        for (int v = 0; v < nv; v++) stamp[v] = -1;
+        for (int i = 0; i < s->n; i++) {
+            const Ins* in = &s->ins[i];
+            if (in->gone || in->res < 0 || !crosses[in->res] || stamp[in->res] == in->block) continue;
+            stamp[in->res] = in->block;
+            if (pass) defblocks[dstart[in->res] + fill[in->res]++] = in->block;
+            else dstart[in->res + 1]++;
+        }
+        if (!pass) {
+            for (int v = 0; v < nv; v++) dstart[v + 1] += dstart[v];
+            defblocks = xcalloc(dstart[nv], sizeof(int));
+        }
+    }
+    free(fill);
+
+    int *df_start, *df;
+    dominance_frontiers(g, &df_start, &df);
+    int* has_phi = xcalloc(nb, sizeof(int));
+    int* queued = xcalloc(nb, sizeof(int));
+    int* work = xcalloc(nb + 1, sizeof(int));
+    for (int b = 0; b < nb; b++) has_phi[b] = queued[b] = -1;
+    int ok = 1;
+    for (int v = 0; v < nv && ok; v++) {
+        if (!crosses[v]) continue;
+        int nwork = 0;
+        work[nwork++] = 0;
+        queued[0] = v;
+        for (int k = dstart[v]; k < dstart[v + 1]; k++) {
+            int b = defblocks[k];
+            if (queued[b] != v) { queued[b] = v; work[nwork++] = b; }
+        }
+        while (nwork > 0) {
+            int x = work[--nwork];
+            for (int k = df_start[x]; k < df_start[x + 1]; k++) {
+                int y = df[k];
+                if (has_phi[y] == v) continue;
+                has_phi[y] = v;
+                add_phi(s, v, y);
+                if (queued[y] != v) { queued[y] = v; work[nwork++] = y; }
+            }
+        }
+        if (s->nphis > SSA_MAX_PHIS_PER_INS * s->n + 64) ok = 0;
+    }
+    free(crosses);
+    free(stamp);
+    free(dstart);
+    free(defblocks);
+    free(df_start);
+    free(df);
+    free(has_phi);
+    free(queued);
+    free(work);
+    return ok;
+}
+
+typedef struct Renamer {
+    int *cur;               // valor -> nombre vigente
+    int *log;               // pares (valor, nombre anterior) para deshacer
+    int nlog, caplog;
+} Renamer;
+
+static void rename_push(Renamer* r, int v, int name) {
+    if (r->nlog + 2 > r->caplog) {
+        r->caplog = r->caplog ? r->caplog * 2 : 256;
+        r->log = xrealloc(r->log, sizeof(int) * r->caplog);
+    }
+    r->log[r->nlog++] = v;
+    r->log[r->nlog++] = r->cur[v];
+    r->cur[v] = name;
+}
+
+static void rename_block(Ssa* s, Renamer* r, int b) {
+    const CFG* g = s->g;
+    int mark = r->nlog;
+    for (int p = s->phi_head[b]; p >= 0; p = s->phis[p].next) {
+        Phi* ph = &s->phis[p];
+        ph->res = new_name(s, ph->value);
+        s->def_phi[ph->res] = p;
+        rename_push(r, ph->value, ph->res);
+    }
+    for (int i = g->blocks[b].first; i < g->blocks[b].last; i++) {
+        Ins* in = &s->ins[i];
+        for (int k = 0; k < 2; k++)
+            if (in->a[k].name >= 0) in->a[k].name = r->cur[in->a[k].name];
+        if (in->res >= 0) {
+            int v = in->res;
+            in->res = new_name(s, v);
+            s->def_ins[in->res] = i;
+            rename_push(r, v, in->res);
+        }
+    }
+    for (int k = 0; k < 2; k++) {
+        int t = g->blocks[b].succ[k];
+        if (t < 0) continue;
+        int j = pred_index(g, t, b);
+        for (int p = s->phi_head[t]; p >= 0; p = s->phis[p].next)
+            phi_args(s, &s->phis[p])[j] = use_name(r->cur[s->phis[p].value]);
+    }
+    for (int c = s->child_start[b]; c < s->child_start[b + 1]; c++)
+        rename_block(s, r, s->children[c]);
+    while (r->nlog > mark) {
+        int old = r->log[--r->nlog];
+        int v = r->log[--r->nlog];
+        r->cur[v] = old;
+    }
+}
+
+static void dominator_tree(Ssa* s) {
+    const CFG* g = s->g;
+    int nb = g->nblocks;
+    s->child_start = xcalloc(nb + 1, sizeof(int));
+    for (int b = 1; b < nb; b++)
+        if (g->blocks[b].rpo >= 0 && g->blocks[b].idom >= 0) s->child_start[g->blocks[b].idom + 1]++;
+    for (int b = 0; b < nb; b++) s->child_start[b + 1] += s->child_start[b];
+    s->children = xcalloc(s->child_start[nb], sizeof(int));
+    int* fill = xcalloc(nb, sizeof(int));
+    for (int b = 1; b < nb; b++) {
+        int d = g->blocks[b].idom;
+        if (g->blocks[b].rpo >= 0 && d >= 0) s->children[s->child_start[d] + fill[d]++] = b;
+    }
+    free(fill);
+}
+
+static int build(Ssa* s) {
+    s->phi_head = xcalloc(s->g->nblocks, sizeof(int));
+    for (int b = 0; b < s->g->nblocks; b++) s->phi_head[b] = -1;
+    for (int v = 0; v < s->nvalues; v++) new_name(s, v);
+    if (!place_phis(s)) return 0;
+    dominator_tree(s);
+
+    Renamer r = { 0 };
+    r.cur = xcalloc(s->nvalues, sizeof(int));
+    for (int v = 0; v < s->nvalues; v++) r.cur[v] = v;
+    // al entrar, cada valor es el de la función (los parámetros, y basura
+    // en las locales sin inicializar, como en memoria)
+    for (int p = s->phi_head[0]; p >= 0; p = s->phis[p].next)
+        phi_args(s, &s->phis[p])[phi_nargs(s, 0) - 1] = use_name(s->phis[p].value);
+    if (s->g->nblocks > 0) rename_block(s, &r, 0);
+    free(r.cur);
+    free(r.log);
+
+    s->repl = xcalloc(s->nnames, sizeof(Use));
+    for (int x = 0; x < s->nnames; x++) s->repl[x].name = NO_REPL;
+    return 1;
+}
+
+static Use resolve(const Ssa* s, Use u) {
+    while (u.name >= 0 && s->repl[u.name].name != NO_REPL) u = s->repl[u.name];
+    return u;
+}
+
+/* ¿la arista del bloque p a b es ejecutable? (p = -1: la entrada) */
+static int edge_exec(const Ssa* s, int p, int b) {
+    if (p < 0) return 1;
+    for (int k = 0; k < 2; k++)
+        if (s->g->blocks[p].succ[k] == b && s->edge_exec[p * 2 + k]) return 1;
+    return 0;
+}
+
+/* predecesor j de b (-1 para la entrada) */
+static int phi_pred(const Ssa* s, int b, int j) {
+    return j < s->g->blocks[b].npreds ? s->g->blocks[b].preds[j] : -1;
+}
+
+/* última instrucción viva de un bloque (-1 si no queda ninguna) */
+static int block_tail(const Ssa* s, int b) {
+    for (int i = s->g->blocks[b].last - 1; i >= s->g->blocks[b].first; i--)
+        if (!s->ins[i].gone) return i;
+    return -1;
+}
+
+static int is_pure(TacOp op) {
+    return op <= TAC_NEG;
+}
+
+/* ---------- SCCP ---------- */
+
+enum { LAT_TOP, LAT_CONST, LAT_BOT };
+
+typedef struct Sccp {
+    Ssa *s;
+    char *lat;
+    int *val;
+    int *users_start, *users;       // nombre -> instrucciones (i) y phis (-p-1) que lo leen
+    int *flow;                      // aristas por visitar (bloque * 2 + k)
+    int nflow;
+    int *names;                     // nombres cuyo valor cambió
+    int nnames, capnames;
+} Sccp;
+
+/* Evalúa op sobre constantes como lo haría el código generado (enteros de
+   32 bits con desborde circular). 0 si no se puede plegar. */
+static int eval_op(TacOp op, int a, int b, int* out) {
+    unsigned ua = (unsigned)a, ub = (unsigned)b;
+    switch (op) {
+        case TAC_ADD: *out = (int)(ua + ub); return 1;
+        case TAC_SUB: *out = (int)(ua - ub); return 1;
+        case TAC_MUL: *out = (int)(ua * ub); return 1;
+        case TAC_DIV:
+        case TAC_MOD:
+            if (b == 0 || (a == INT_MIN && b == -1)) return 0;     // idiv atrapa
+            *out = op == TAC_DIV ? a / b : a % b;
+            return 1;
+        case TAC_LT: *out = a < b; return 1;
+        case TAC_GT: *out = a > b; return 1;
+        case TAC_EQ: *out = a == b; return 1;
+        case TAC_AND: *out = a != 0 && b != 0; return 1;
+        case TAC_OR: *out = a != 0 || b != 0; return 1;
+        case TAC_NOT: *out = a == 0; return 1;
+        case TAC_NEG: *out = (int)(0u - ua); return 1;
+        default: return 0;
+    }
+}
+
+static char lat_of(const Sccp* sc, Use u, int* v) {
+    if (u.name >= 0) {
+        *v = sc->val[u.name];
+        return sc->lat[u.name];
+    }
+    if (u.o.kind == OPND_IMM) {
+        *v = u.o.imm;
+        return LAT_CONST;
+    }
+    *v = 0;
+    return u.o.kind == OPND_NONE ? LAT_CONST : LAT_BOT;     // global: cualquier cosa
+}
+
+static void set_lat(Sccp* sc, int x, char l, int v) {
+    char old = sc->lat[x];
+    if (l == LAT_TOP || old == LAT_BOT) return;
+    if (old == LAT_CONST && (l == LAT_BOT || sc->val[x] != v)) l = LAT_BOT;
+    else if (old == LAT_CONST) return;
+    sc->lat[x] = l;
+    sc->val[x] = v;
+    if (sc->nnames == sc->capnames) {
+        sc->capnames = sc->capnames ? sc->capnames * 2 : 64;
+        sc->names = xrealloc(sc->names, sizeof(int) * sc->capnames);
+    }
+    sc->names[sc->nnames++] = x;
+}
+
+static void mark_edge(Sccp* sc, int b, int k) {
+    Ssa* s = sc->s;
+    if (s->g->blocks[b].succ[k] < 0 || s->edge_exec[b * 2 + k]) return;
+    s->edge_exec[b * 2 + k] = 1;
+    sc->flow[sc->nflow++] = b * 2 + k;
+}
+
+static void visit_phi(Sccp* sc, int p) {
+    Ssa* s = sc->s;
+    const Phi* ph = &s->phis[p];
+    if (!s->block_exec[ph->block]) return;
+    char l = LAT_TOP;
+    int v = 0;
+    const Use* args = phi_args(s, ph);
+    for (int j = 0; j < phi_nargs(s, ph->block); j++) {
+        if (is_none(args[j]) || !edge_exec(s, phi_pred(s, ph->block, j), ph->block)) continue;
+        int av;
+        char al = lat_of(sc, args[j], &av);
+        if (al == LAT_TOP) continue;
+        if (al == LAT_BOT || (l == LAT_CONST && av != v)) { l = LAT_BOT; break; }
+        l = LAT_CONST;
+        v = av;
+    }
+    set_lat(sc, ph->res, l, v);
+}
+
+static void visit_ins(Sccp* sc, int i) {
+    Ssa* s = sc->s;
+    const Ins* in = &s->ins[i];
+    if (in->gone || !s->block_exec[in->block]) return;
+    const BasicBlock* bb = &s->g->blocks[in->block];
+    int a, b, r;
+    char la, lb;
+    switch (in->op) {
+    case TAC_IF_FALSE_GOTO: {
+        // [0] es el salto; la caída es [1] salvo que salte al siguiente
+        int fall = bb->succ[1] >= 0 ? 1 : 0;
+        la = lat_of(sc, in->a[0], &a);
+        if (la == LAT_TOP) return;
+        if (la == LAT_BOT || a == 0) mark_edge(sc, in->block, 0);
+        if (la == LAT_BOT || a != 0) mark_edge(sc, in->block, fall);
+        return;
+    }
+    case TAC_GOTO:
+        mark_edge(sc, in->block, 0);
+        return;
+    case TAC_CALL:
+        if (in->res >= 0) set_lat(sc, in->res, LAT_BOT, 0);
+        return;
+    case TAC_COPY:
+    case TAC_ASSIGN:
+        if (in->res < 0) return;
+        la = lat_of(sc, in->a[0], &a);
+        set_lat(sc, in->res, la, a);
+        return;
+    default:
+        break;
+    }
+    if (!is_pure(in->op) || in->res < 0) return;
+    la = lat_of(sc, in->a[0], &a);
+    lb = lat_of(sc, in->a[1], &b);
+    // un operando conocido puede bastar
+    if ((in->op == TAC_AND && ((la == LAT_CONST && !a) || (lb == LAT_CONST && !b))) ||
+        (in->op == TAC_MUL && ((la == LAT_CONST && !a) || (lb == LAT_CONST && !b)))) {
+        set_lat(sc, in->res, LAT_CONST, 0);
+        return;
+    }
+    if (in->op == TAC_OR && ((la == LAT_CONST && a) || (lb == LAT_CONST && b))) {
+        set_lat(sc, in->res, LAT_CONST, 1);
+        return;
+    }
+    if (la == LAT_BOT || lb == LAT_BOT) set_lat(sc, in->res, LAT_BOT, 0);
+    else if (la == LAT_CONST && lb == LAT_CONST) {
+        if (eval_op(in->op, a, b, &r)) set_lat(sc, in->res, LAT_CONST, r);
+        else set_lat(sc, in->res, LAT_BOT, 0);
+    }
+}
+
+/* el bloque b se vuelve ejecutable: se visita entero */
+static void visit_block(Sccp* sc, int b) {
+    Ssa* s = sc->s;
+    s->block_exec[b] = 1;
+    for (int p = s->phi_head[b]; p >= 0; p = s->phis[p].next) visit_phi(sc, p);
+    for (int i = s->g->blocks[b].first; i < s->g->blocks[b].last; i++) visit_ins(sc, i);
+    int t = block_tail(s, b);
+    TacOp op = t >= 0 ? s->ins[t].op : TAC_LABEL;
+    if (op != TAC_GOTO && op != TAC_IF_FALSE_GOTO && op != TAC_RETURN) mark_edge(sc, b, 0);
+}
+
+static void build_users(Sccp* sc) {
+    Ssa* s = sc->s;
+    int* start = xcalloc(s->nnames + 1, sizeof(int));
+    int* list = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+        int* fill = pass ? xcalloc(s->nnames, sizeof(int)) : NULL;
+#define ADD_USER(x, who) do { if (pass) list[start[x] + fill[x]++] = (who); else start[(x) + 1]++; } while (0)
+        for (int i = 0; i < s->n; i++) {
+            if (s->ins[i].gone) continue;
+            for (int k = 0; k < 2; k++)
+                if (s->ins[i].a[k].name >= 0) ADD_USER(s->ins[i].a[k].name, i);
+        }
+        for (int p = 0; p < s->nphis; p++) {
+            const Use* args = phi_args(s, &s->phis[p]);
+            for (int j = 0; j < phi_nargs(s, s->phis[p].block); j++)
+                if (args[j].name >= 0) ADD_USER(args[j].name, -p - 1);
+        }
+#undef ADD_USER
+        if (!pass) {
+            for (int x = 0; x < s->nnames; x++) start[x + 1] += start[x];
+            list = xcalloc(start[s->nnames], sizeof(int));
+        }
+        free(fill);
+    }
+    sc->users_start = start;
+    sc->users = list;
+}
+
+/* Propagación de constantes condicional (Wegman y Zadeck): las constantes
+   reemplazan a sus nombres, los bloques que no se alcanzan desaparecen y
+   las ramas de condición constante se vuelven saltos o caídas */
+static void sccp(Ssa* s) {
+    Sccp sc = { .s = s };
+    sc.lat = xcalloc(s->nnames, 1);
+    sc.val = xcalloc(s->nnames, sizeof(int));
+    for (int x = 0; x < s->nvalues; x++) sc.lat[x] = LAT_BOT;
+    sc.flow = xcalloc(s->g->nblocks * 2, sizeof(int));
+    build_users(&sc);
+
+    if (s->g->nblocks > 0) visit_block(&sc, 0);
+    while (sc.nflow > 0 || sc.nnames > 0) {
+        if (sc.nflow > 0) {
+            int e = sc.flow[--sc.nflow];
+            int t = s->g->blocks[e / 2].succ[e % 2];
+            if (!s->block_exec[t]) {
+                visit_block(&sc, t);
+            } else {
+                for (int p = s->phi_head[t]; p >= 0; p = s->phis[p].next) visit_phi(&sc, p);
+            }
+            continue;
+        }
+        int x = sc.names[--sc.nnames];
+        for (int k = sc.users_start[x]; k < sc.users_start[x + 1]; k++) {
+            int u = sc.users[k];
+            if (u >= 0) visit_ins(&sc, u);
+            else visit_phi(&sc, -u - 1);
+        }
+    }
+
+    for (int i = 0; i < s->n; i++) {
+        Ins* in = &s->ins[i];
+        if (in->gone) continue;
+        if (!s->block_exec[in->block]) { in->gone = 1; continue; }
+        if (in->res >= 0 && sc.lat[in->res] == LAT_CONST) {
+            s->repl[in->res] = use_imm(sc.val[in->res]);
+            in->gone = 1;
+            continue;
+        }
+        if (in->op == TAC_IF_FALSE_GOTO) {
+            int c;
+            if (lat_of(&sc, in->a[0], &c) != LAT_CONST) continue;
+            if (c != 0) in->gone = 1;
+            else in->op = TAC_GOTO, in->a[0] = use_none();
+        }
+    }
+    for (int p = 0; p < s->nphis; p++) {
+        Phi* ph = &s->phis[p];
+        if (!s->block_exec[ph->block]) { ph->gone = 1; continue; }
+        if (sc.lat[ph->res] == LAT_CONST) {
+            s->repl[ph->res] = use_imm(sc.val[ph->res]);
+            ph->gone = 1;
+            continue;
+        }
+        Use* args = phi_args(s, ph);
+        for (int j = 0; j < phi_nargs(s, ph->block); j++)
+            if (!edge_exec(s, phi_pred(s, ph->block, j), ph->block)) args[j] = use_none();
+    }
+    free(sc.lat);
+    free(sc.val);
+    free(sc.flow);
+    free(sc.names);
+    free(sc.users_start);
+    free(sc.users);
+}
+
+/* ---------- GVN ---------- */
+
+typedef struct VnEntry {
+    TacOp op;
+    long long k1, k2;
+    int name;
+    int next;
+} VnEntry;
+
+typedef struct VnTable {
+    int *heads;
+    unsigned mask;
+    VnEntry *e;
+    int count, cap;
+} VnTable;
+
+static long long use_key(Use u) {
+    return u.name >= 0 ? (long long)u.name * 2 : (long long)u.o.imm * 2 + 1;
+}
+
+static unsigned vn_hash(TacOp op, long long k1, long long k2) {
+    unsigned long long h = (unsigned long long)op * 0x9E3779B97F4A7C15ULL;
+    h ^= (unsigned long long)k1 + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+    h ^= (unsigned long long)k2 + 0x8CB92BA72F3D8DD7ULL + (h << 6) + (h >> 2);
+    return (unsigned)(h ^ (h >> 32));
+}
+
+static int commutative(TacOp op) {
+    return op == TAC_ADD || op == TAC_MUL || op == TAC_EQ || op == TAC_AND || op == TAC_OR;
+}
+
+/* Numeración de valores en preorden del árbol de dominadores, con una tabla
+   con alcance: lo que está en la tabla domina al bloque que se recorre */
+static void gvn_block(Ssa* s, VnTable* t, int b) {
+    if (!s->block_exec[b]) return;
+    int mark = t->count;
+    for (int p = s->phi_head[b]; p >= 0; p = s->phis[p].next) {
+        Phi* ph = &s->phis[p];
+        if (ph->gone) continue;
+        // un phi cuyos argumentos (salvo él mismo) son todos iguales es copia
+        Use* args = phi_args(s, ph);
+        Use same = use_none();
+        int all_same = 1;
+        for (int j = 0; j < phi_nargs(s, b); j++) {
+            if (is_none(args[j])) continue;
+            args[j] = resolve(s, args[j]);
+            if (args[j].name == ph->res) continue;
+            if (is_none(same)) same = args[j];
+            else if (!same_use(same, args[j])) all_same = 0;
+        }
+        if (all_same && !is_none(same)) {
+            s->repl[ph->res] = same;
+            ph->gone = 1;
+        }
+    }
+    for (int i = s->g->blocks[b].first; i < s->g->blocks[b].last; i++) {
+        Ins* in = &s->ins[i];
+        if (in->gone) continue;
+        int local = 1;          // operandos propios o inmediatos (no globales)
+        for (int k = 0; k < 2; k++) {
+            in->a[k] = resolve(s, in->a[k]);
+            if (in->a[k].name < 0 && in->a[k].o.kind != OPND_IMM && in->a[k].o.kind != OPND_NONE)
+                local = 0;
+        }
+        if (in->res < 0 || !local) continue;
+        if (in->op == TAC_COPY || in->op == TAC_ASSIGN) {
+            s->repl[in->res] = in->a[0];
+            in->gone = 1;
+            continue;
+        }
+        if (!is_pure(in->op)) continue;
+        long long k1 = use_key(in->a[0]);
+        long long k2 = in->a[1].o.kind == OPND_NONE && in->a[1].name < 0 ? 0 : use_key(in->a[1]);
+        if (commutative(in->op) && k1 > k2) {
+            long long tmp = k1; k1 = k2; k2 = tmp;
+        }
+        unsigned h = vn_hash(in->op, k1, k2) & t->mask;
+        int found = -1;
+        for (int e = t->heads[h]; e >= 0; e = t->e[e].next) {
+            if (t->e[e].op == in->op && t->e[e].k1 == k1 && t->e[e].k2 == k2) {
+                found = t->e[e].name;
+                break;
+            }
+        }
+        if (found >= 0) {
+            s->repl[in->res] = use_name(found);
+            in->gone = 1;
+            continue;
+        }
+        if (t->count == t->cap) {
+            t->cap = t->cap ? t->cap * 2 : 256;
+            t->e = xrealloc(t->e, sizeof(VnEntry) * t->cap);
+        }
+        VnEntry* e = &t->e[t->count];
+        e->op = in->op;
+        e->k1 = k1;
+        e->k2 = k2;
+        e->name = in->res;
+        e->next = t->heads[h];
+        t->heads[h] = t->count++;
+    }
+    for (int c = s->child_start[b]; c < s->child_start[b + 1]; c++)
+        gvn_block(s, t, s->children[c]);
+    // al salir del subárbol, lo que agregó deja de dominar
+    while (t->count > mark) {
+        VnEntry* e = &t->e[--t->count];
+        t->heads[vn_hash(e->op, e->k1, e->k2) & t->mask] = e->next;
+    }
+}
+
+static void gvn(Ssa* s) {
+    VnTable t = { 0 };
+    unsigned cap = 64;
+    while (cap < (unsigned)s->n * 2) cap <<= 1;
+    t.heads = xcalloc(cap, sizeof(int));
+    for (unsigned i = 0; i < cap; i++) t.heads[i] = -1;
+    t.mask = cap - 1;
+    if (s->g->nblocks > 0) gvn_block(s, &t, 0);
+    free(t.heads);
+    free(t.e);
+
+    // los usos que quedaron (p.ej. phis de lazos) toman el valor final
+    for (int i = 0; i < s->n; i++)
+        for (int k = 0; k < 2; k++) s->ins[i].a[k] = resolve(s, s->ins[i].a[k]);
+    for (int p = 0; p < s->nphis; p++) {
+        Use* args = phi_args(s, &s->phis[p]);
+        for (int j = 0; j < phi_nargs(s, s->phis[p].block); j++)
+            if (!is_none(args[j])) args[j] = resolve(s, args[j]);
+    }
+}
+
+/* ---------- ADCE ---------- */
+
+typedef struct Adce {
+    Ssa *s;
+    int *ipdom;             // posdominador inmediato; nblocks es la salida
+    int *cd_head, *cd_next, *cd_block;      // dependencia de control
+    int ncd, capcd;
+    char *block_live;
+    int *work;              // instrucciones (i) y phis (-p-1) por recorrer
+    int nwork;
+} Adce;
+
+/* bloques de los que sale la función */
+static int is_exit_block(const Ssa* s, int b) {
+    int t = block_tail(s, b);
+    if (t >= 0 && s->ins[t].op == TAC_RETURN) return 1;
+    return !s->edge_exec[b * 2] && !s->edge_exec[b * 2 + 1];
+}
+
+/* Posdominadores sobre el grafo que quedó tras SCCP (bloques y aristas
+   ejecutables), con la misma iteración que los dominadores sobre el grafo
+   invertido. Devuelve 0 si algún bloque no llega a la salida (un lazo
+   infinito): entonces no hay dependencia de control que usar. */
+static int postdominators(Adce* a) {
+    Ssa* s = a->s;
+    const CFG* g = s->g;
+    int nb = g->nblocks, exit = nb;
+    int* order = xcalloc(nb + 1, sizeof(int));
+    int* num = xcalloc(nb + 1, sizeof(int));
+    int* stack = xcalloc(nb + 1, sizeof(int));
+    int* next = xcalloc(nb + 1, sizeof(int));
+    for (int b = 0; b <= nb; b++) num[b] = -1;
+
+    // postorden inverso del grafo invertido desde la salida
+    int npost = 0, sp = 0;
+    int* post = xcalloc(nb + 1, sizeof(int));
+    char* seen = xcalloc(nb + 1, 1);
+    stack[sp++] = exit;
+    seen[exit] = 1;
+    while (sp > 0) {
+        int b = stack[sp - 1];
+        int pushed = 0;
+        // sucesores en el grafo invertido: los predecesores (todos los
+        // bloques de salida si b es la salida)
+        if (b == exit) {
+            while (next[b] < nb) {
+                int p = next[b]++;
+                if (s->block_exec[p] && !seen[p] && is_exit_block(s, p)) {
+                    seen[p] = 1;
+                    stack[sp++] = p;
+                    pushed = 1;
+                    break;
+                }
+            }
+        } else {
+            while (next[b] < g->blocks[b].npreds) {
+                int p = g->blocks[b].preds[next[b]++];
+                if (s->block_exec[p] && !seen[p] && edge_exec(s, p, b)) {
+                    seen[p] = 1;
+                    stack[sp++] = p;
+                    pushed = 1;
+                    break;
+                }
+            }
+        }
+        if (!pushed) {
+            post[npost++] = b;
+            sp--;
+        }
+    }
+    int ok = 1;
+    for (int b = 0; b < nb; b++)
+        if (s->block_exec[b] && !seen[b]) ok = 0;
+    for (int i = 0; i < npost; i++) {
+        order[i] = post[npost - 1 - i];
+        num[order[i]] = i;
+    }
+
+    int* ip = a->ipdom;
+    for (int b = 0; b <= nb; b++) ip[b] = -1;
+    ip[exit] = exit;
+    int changed = ok;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < npost; i++) {
+            int b = order[i];
+            int best = -1;
+            // predecesores en el grafo invertido: los sucesores ejecutables
+            int cand[3], nc = 0;
+            for (int k = 0; k < 2; k++)
+                if (s->edge_exec[b * 2 + k]) cand[nc++] = g->blocks[b].succ[k];
+            if (is_exit_block(s, b)) cand[nc++] = exit;
+            for (int c = 0; c < nc; c++) {
+                int x = cand[c];
+                if (ip[x] < 0) continue;
+                if (best < 0) { best = x; continue; }
+                int y = best;
+                while (x != y) {
+                    while (num[x] > num[y]) x = ip[x];
+                    while (num[y] > num[x]) y = ip[y];
+                }
+                best = x;
+            }
+            if (best != ip[b]) {
+                ip[b] = best;
+                changed = 1;
+            }
+        }
+    }
+    free(order);
+    free(num);
+    free(stack);
+    free(next);
+    free(post);
+    free(seen);
+    return ok;
+}
+
+static void add_cd(Adce* a, int b, int on) {
+    if (a->ncd == a->capcd) {
+        a->capcd = a->capcd ? a->capcd * 2 : 64;
+        a->cd_next = xrealloc(a->cd_next, sizeof(int) * a->capcd);
+        a->cd_block = xrealloc(a->cd_block, sizeof(int) * a->capcd);
+    }
+    a->cd_block[a->ncd] = on;
+    a->cd_next[a->ncd] = a->cd_head[b];
+    a->cd_head[b] = a->ncd++;
+}
+
+static void adce_mark_ins(Adce* a, int i) {
+    if (i < 0 || a->s->ins[i].live) return;
+    a->s->ins[i].live = 1;
+    a->work[a->nwork++] = i;
+}
+
+static void adce_mark_def(Adce* a, Use u) {
+    Ssa* s = a->s;
+    if (u.name < 0) return;
+    if (s->def_ins[u.name] >= 0) {
+        adce_mark_ins(a, s->def_ins[u.name]);
+    } else if (s->def_phi[u.name] >= 0) {
+        Phi* ph = &s->phis[s->def_phi[u.name]];
+        if (ph->live) return;
+        ph->live = 1;
+        a->work[a->nwork++] = -s->def_phi[u.name] - 1;
+    }
+}
+
+/* un bloque con algo vivo mantiene las ramas de las que depende */
+static void adce_mark_block(Adce* a, int b) {
+    if (b < 0 || a->block_live[b]) return;
+    a->block_live[b] = 1;
+    for (int c = a->cd_head[b]; c >= 0; c = a->cd_next[c])
+        adce_mark_ins(a, block_tail(a->s, a->cd_block[c]));
+}
+
+/* Eliminación agresiva de código muerto (Cytron et al.): solo se conserva
+   lo que alimenta llamadas, retornos y escrituras a globales, y las ramas
+   de las que eso depende; una rama muerta salta directo a su
+   posdominador */
+static void adce(Ssa* s) {
+    const CFG* g = s->g;
+    int nb = g->nblocks;
+    Adce a = { .s = s };
+    a.ipdom = xcalloc(nb + 1, sizeof(int));
+    a.cd_head = xcalloc(nb, sizeof(int));
+    for (int b = 0; b < nb; b++) a.cd_head[b] = -1;
+    a.block_live = xcalloc(nb, 1);
+    a.work = xcalloc(s->n + s->nphis, sizeof(int));
+    int has_pdom = postdominators(&a);
+
+    // una rama que no puede saltar a su posdominador se queda
+    for (int b = 0; b < nb; b++) {
+        if (!s->block_exec[b]) continue;
+        int t = block_tail(s, b);
+        if (t < 0 || s->ins[t].op != TAC_IF_FALSE_GOTO) continue;
+        int pd = has_pdom ? a.ipdom[b] : -1;
+        if (pd < 0 || pd == nb || s->ins[g->blocks[pd].first].op != TAC_LABEL ||
+            s->ins[g->blocks[pd].first].gone) {
+            adce_mark_ins(&a, t);
+            continue;
+        }
+        for (int k = 0; k < 2; k++) {
+            if (!s->edge_exec[b * 2 + k]) continue;
+            for (int r = g->blocks[b].succ[k]; r != pd && r >= 0 && r < nb; r = a.ipdom[r])
+                add_cd(&a, r, b);
+        }
+    }
+    for (int i = 0; i < s->n; i++) {
+        const Ins* in = &s->ins[i];
+        if (in->gone) continue;
+        if (in->op == TAC_CALL || in->op == TAC_PARAM || in->op == TAC_RETURN ||
+            (in->res < 0 && in->raw_res.kind == OPND_VAR))
+            adce_mark_ins(&a, i);
+    }
+    while (a.nwork > 0) {
+        int w = a.work[--a.nwork];
+        if (w >= 0) {
+            const Ins* in = &s->ins[w];
+            adce_mark_def(&a, in->a[0]);
+            adce_mark_def(&a, in->a[1]);
+            adce_mark_block(&a, in->block);
+        } else {
+            const Phi* ph = &s->phis[-w - 1];
+            const Use* args = phi_args(s, ph);
+            for (int j = 0; j < phi_nargs(s, ph->block); j++) {
+                if (is_none(args[j])) continue;
+                adce_mark_def(&a, args[j]);
+                adce_mark_block(&a, phi_pred(s, ph->block, j));
+            }
+        }
+    }
+
+    for (int i = 0; i < s->n; i++) {
+        Ins* in = &s->ins[i];
+        if (in->gone || in->live || in->op == TAC_LABEL || in->op == TAC_GOTO) continue;
+        if (in->op == TAC_IF_FALSE_GOTO) {
+            const TAC* target = &s->g->code[g->blocks[a.ipdom[in->block]].first];
+            in->op = TAC_GOTO;
+            in->a[0] = use_none();
+            in->raw_res = target->result;
+        } else {
+            in->gone = 1;
+        }
+    }
+    for (int p = 0; p < s->nphis; p++)
+        if (!s->phis[p].live) s->phis[p].gone = 1;
+
+    free(a.ipdom);
+    free(a.cd_head);
+    free(a.cd_next);
+    free(a.cd_block);
+    free(a.block_live);
+    free(a.work);
+}
+
+/* ---------- Salida de SSA ---------- */
+
+typedef struct Emitter {
+    Ssa *s;
+    TAC *code;
+    int n, cap;
+    int *temp_of;           // nombre -> temporal de la salida (-1: aún no)
+    int ntemps;
+    Copy *copies;
+    int ncopies, capcopies;
+    int *tail_copies;       // por bloque: copias al final (antes del salto)
+    int *head_copies;       // por bloque: copias después de la etiqueta
+    int entry_copies;       // antes de la primera instrucción
+} Emitter;
+
+static void add_copy(Emitter* e, int* list, int dst, Use src) {
+    if (e->ncopies == e->capcopies) {
+        e->capcopies = e->capcopies ? e->capcopies * 2 : 64;
+        e->copies = xrealloc(e->copies, sizeof(Copy) * e->capcopies);
+    }
+    Copy* c = &e->copies[e->ncopies];
+    c->dst = dst;
+    c->src = src;
+    // en orden de llegada, así las copias de un borde quedan en orden de phis
+    c->next = -1;
+    int* at = list;
+    while (*at >= 0) at = &e->copies[*at].next;
+    *at = e->ncopies++;
+}
+
+/* ¿otro phi de b lee el resultado del phi p? */
+static int read_by_phi(const Ssa* s, int b, int p) {
+    for (int q = s->phi_head[b]; q >= 0; q = s->phis[q].next) {
+        if (q == p || s->phis[q].gone) continue;
+        const Use* args = phi_args(s, &s->phis[q]);
+        for (int j = 0; j < phi_nargs(s, b); j++)
+            if (args[j].name == s->phis[p].res) return 1;
+    }
+    return 0;
+}
+
+/* Cada phi vivo x = phi(a1..ak) se vuelve copias. Si todos los
+   predecesores llegan sin condición y ningún otro phi del bloque lee x, la
+   copia escribe x directamente al final de cada predecesor (y si ai se
+   calcula ahí y no se usa en otro lado, se calcula directo en x). Si no,
+   pasa por un temporal nuevo x' (x' = ai en los predecesores, x = x'
+   después de la etiqueta): así no pisa un x que sigue vivo en la otra
+   rama ni el que lee otro phi (un intercambio). */
+static void lower_phis(Emitter* e) {
+    Ssa* s = e->s;
+    const CFG* g = s->g;
+    int* uses = xcalloc(s->nnames, sizeof(int));
+    for (int i = 0; i < s->n; i++) {
+        if (s->ins[i].gone) continue;
+        for (int k = 0; k < 2; k++)
+            if (s->ins[i].a[k].name >= 0) uses[s->ins[i].a[k].name]++;
+    }
+    for (int p = 0; p < s->nphis; p++) {
+        if (s->phis[p].gone) continue;
+        const Use* args = phi_args(s, &s->phis[p]);
+        for (int j = 0; j < phi_nargs(s, s->phis[p].block); j++)
+            if (args[j].name >= 0) uses[args[j].name]++;
+    }
+
+    for (int b = 0; b < g->nblocks; b++) {
+        int any = 0;
+        for (int p = s->phi_head[b]; p >= 0; p = s->phis[p].next) any |= !s->phis[p].gone;
+        if (!any) continue;
+        int nargs = phi_nargs(s, b);
+
+        int unconditional = 1;
+        for (int j = 0; j < nargs; j++) {
+            int pred = phi_pred(s, b, j);
+            int t = pred >= 0 ? block_tail(s, pred) : -1;
+            if (t >= 0 && s->ins[t].op == TAC_IF_FALSE_GOTO) unconditional = 0;
+        }
+
+        for (int p = s->phi_head[b]; p >= 0; p = s->phis[p].next) {
+            Phi* ph = &s->phis[p];
+            if (ph->gone) continue;
+            int direct = unconditional && !read_by_phi(s, b, p);
+            int dst = ph->res;
+            if (!direct) {
+                dst = new_name(s, ph->value);
+                add_copy(e, &e->head_copies[b], ph->res, use_name(dst));
+            }
+            const Use* args = phi_args(s, ph);
+            for (int j = 0; j < nargs; j++) {
+                Use u = args[j];
+                if (is_none(u) || u.name == dst) continue;
+                int pred = phi_pred(s, b, j);
+                if (pred < 0) {
+                    add_copy(e, &e->entry_copies, dst, u);
+                    continue;
+                }
+                int d = u.name >= 0 ? s->def_ins[u.name] : -1;
+                if (direct && d >= 0 && uses[u.name] == 1 && !s->ins[d].gone &&
+                    s->ins[d].block == pred) {
+                    int reads = 0;
+                    for (int i = d + 1; i < g->blocks[pred].last && !reads; i++) {
+                        if (s->ins[i].gone) continue;
+                        reads = s->ins[i].a[0].name == dst || s->ins[i].a[1].name == dst;
+                    }
+                    if (!reads) {
+                        s->ins[d].res = dst;
+                        continue;
+                    }
+                }
+                add_copy(e, &e->tail_copies[pred], dst, u);
+            }
+        }
+    }
+    free(uses);
+}
+
+static TAC* emit_slot(Emitter* e) {
+    if (e->n == e->cap) {
+        e->cap = e->cap ? e->cap * 2 : 64;
+        e->code = xrealloc(e->code, sizeof(TAC) * e->cap);
+    }
+    TAC* t = &e->code[e->n++];
+    memset(t, 0, sizeof(*t));
+    return t;
+}
+
+/* operando de salida de un nombre: las variables al entrar siguen siendo
+   la variable; lo demás, temporales numerados de nuevo desde 0 */
+static Operand name_operand(Emitter* e, int x) {
+    Ssa* s = e->s;
+    Operand o = { .kind = OPND_TEMP };
+    if (x < s->nvars) return s->vars[x];
+    if (e->temp_of[x] < 0) e->temp_of[x] = e->ntemps++;
+    o.temp = e->temp_of[x];
+    return o;
+}
+
+static Operand use_operand(Emitter* e, Use u) {
+    return u.name >= 0 ? name_operand(e, u.name) : u.o;
+}
+
+static void emit_copies(Emitter* e, int list) {
+    for (int c = list; c >= 0; c = e->copies[c].next) {
+        TAC* t = emit_slot(e);
+        t->op = TAC_COPY;
+        t->arg1 = use_operand(e, e->copies[c].src);
+        t->result = name_operand(e, e->copies[c].dst);
+    }
+}
+
+static void emit_ins(Emitter* e, const Ins* in) {
+    // una condición que quedó constante (p.ej. por un phi) ya no es rama
+    if (in->op == TAC_IF_FALSE_GOTO && in->a[0].name < 0 && in->a[0].o.kind == OPND_IMM) {
+        if (in->a[0].o.imm != 0) return;
+        TAC* t = emit_slot(e);
+        t->op = TAC_GOTO;
+        t->result = in->raw_res;
+        return;
+    }
+    TAC* t = emit_slot(e);
+    t->op = in->op;
+    t->arg1 = use_operand(e, in->a[0]);
+    t->arg2 = use_operand(e, in->a[1]);
+    t->result = in->res >= 0 ? name_operand(e, in->res) : in->raw_res;
+}
+
+static void emit_all(Emitter* e) {
+    Ssa* s = e->s;
+    const CFG* g = s->g;
+    emit_copies(e, e->entry_copies);
+    for (int b = 0; b < g->nblocks; b++) {
+        int tail_done = 0;
+        int first = g->blocks[b].first;
+        if (s->ins[first].op != TAC_LABEL) emit_copies(e, e->head_copies[b]);
+        for (int i = first; i < g->blocks[b].last; i++) {
+            const Ins* in = &s->ins[i];
+            if (in->gone) continue;
+            if (in->op == TAC_GOTO || in->op == TAC_IF_FALSE_GOTO || in->op == TAC_RETURN) {
+                emit_copies(e, e->tail_copies[b]);
+                tail_done = 1;
+            }
+            emit_ins(e, in);
+            if (i == first && in->op == TAC_LABEL) emit_copies(e, e->head_copies[b]);
+        }
+        if (!tail_done) emit_copies(e, e->tail_copies[b]);
+    }
+}
+
+/* Limpieza final: fuera los bloques que quedaron sin alcanzar, los saltos
+   a la instrucción siguiente y las etiquetas a las que ya nadie salta */
+static TAC* tidy(TAC* code, int n, int* out_n) {
+    CFG g;
+    cfg_build(&g, code, n);
+    int m = 0;
+    for (int i = 0; i < n; i++)
+        if (g.blocks[g.block_of[i]].rpo >= 0) code[m++] = code[i];
+    cfg_free(&g);
+    int k = 0;
+    for (int i = 0; i < m; i++) {
+        if (code[i].op == TAC_GOTO && i + 1 < m && code[i + 1].op == TAC_LABEL &&
+            code[i + 1].result.kind == OPND_LABEL && code[i].result.kind == OPND_LABEL &&
+            code[i + 1].result.label == code[i].result.label)
+            continue;
+        code[k++] = code[i];
+    }
+
+    int lmin = INT_MAX, lmax = INT_MIN;
+    for (int i = 0; i < k; i++) {
+        if (code[i].op != TAC_LABEL || code[i].result.kind != OPND_LABEL) continue;
+        if (code[i].result.label < lmin) lmin = code[i].result.label;
+        if (code[i].result.label > lmax) lmax = code[i].result.label;
+    }
+    char* target = xcalloc(lmin <= lmax ? lmax - lmin + 1 : 0, 1);
+    for (int i = 0; i < k; i++) {
+        const Operand* l = &code[i].result;
+        if ((code[i].op == TAC_GOTO || code[i].op == TAC_IF_FALSE_GOTO) &&
+            l->kind == OPND_LABEL && l->label >= lmin && l->label <= lmax)
+            target[l->label - lmin] = 1;
+    }
+    m = 0;
+    for (int i = 0; i < k; i++) {
+        if (code[i].op == TAC_LABEL && code[i].result.kind == OPND_LABEL &&
+            !target[code[i].result.label - lmin])
+            continue;
+        code[m++] = code[i];
+    }
+    free(target);
+    *out_n = m;
+    // el cuerpo vive hasta que se emite la función: sin la holgura del buffer
+    return xrealloc(code, sizeof(TAC) * m);
+}
+
+static void ssa_free(Ssa* s) {
+    free(s->ins);
+    free(s->phis);
+    free(s->phi_head);
+    free(s->args);
+    free(s->name_value);
+    free(s->def_ins);
+    free(s->def_phi);
+    free(s->repl);
+    free(s->child_start);
+    free(s->children);
+    free(s->block_exec);
+    free(s->edge_exec);
+}
+
+TAC* ssa_optimize(const TAC* code, int n, const int (*vals)[3],
+                  const Operand* vars, int nvars, int ntemps, int* out_n) {
+    if (n == 0) return NULL;
+    CFG g;
+    cfg_build(&g, code, n);
+    Ssa s = { .g = &g, .n = n, .nvalues = nvars + ntemps, .nvars = nvars, .vars = vars };
+    load_code(&s, code, vals);
+    if (!build(&s)) {
+        ssa_free(&s);
+        cfg_free(&g);
+        return NULL;
+    }
+    s.block_exec = xcalloc(g.nblocks, 1);
+    s.edge_exec = xcalloc(g.nblocks * 2, 1);
+    sccp(&s);
+    gvn(&s);
+    adce(&s);
+
+    Emitter e = { .s = &s, .entry_copies = -1 };
+    e.tail_copies = xcalloc(g.nblocks, sizeof(int));
+    e.head_copies = xcalloc(g.nblocks, sizeof(int));
+    for (int b = 0; b < g.nblocks; b++) e.tail_copies[b] = e.head_copies[b] = -1;
+    lower_phis(&e);
+    e.temp_of = xcalloc(s.nnames, sizeof(int));
+    for (int x = 0; x < s.nnames; x++) e.temp_of[x] = -1;
+    emit_all(&e);
+
+    free(e.temp_of);
+    free(e.copies);
+    free(e.tail_copies);
+    free(e.head_copies);
+    ssa_free(&s);
+    cfg_free(&g);
+    return tidy(e.code, e.n, out_n);
+}
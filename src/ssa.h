@@ -0,0 +1,24 @@
+#ifndef SSA_H
+#define SSA_H
+#include "codegen.h"
+
+/* ---------- Optimizaciones escalares en SSA (-O2) ----------
+ * El cuerpo de una función se pasa a SSA (phis en la frontera de
+ * dominancia, solo para los valores que viven entre bloques) y se optimiza:
+ * propagación de constantes condicional (SCCP, que además descarta las
+ * ramas que nunca se toman), numeración de valores sobre el árbol de
+ * dominadores (GVN, con propagación de copias) y eliminación agresiva de
+ * código muerto (ADCE, sobre la dependencia de control). Al salir de SSA
+ * cada phi se vuelve copias al final de sus predecesores. Las variables
+ * propias pasan a temporales; las globales no se tocan.
+ */
+
+/* Optimiza [code, code + n). vals[i] son los valores que lee (0 y 1) y
+   escribe (2) la instrucción i, o -1, como para regalloc_function: los
+   valores 0..nvars-1 son las variables propias (vars[v] su operando) y
+   nvars + t el temporal t. Devuelve el cuerpo nuevo (liberar con free) y
+   su largo en *out_n, o NULL si la función no se puede tratar. */
+TAC* ssa_optimize(const TAC* code, int n, const int (*vals)[3],
+                  const Operand* vars, int nvars, int ntemps, int* out_n);
+
+#endif
@@ -2,44 +2,65 @@
 #include <stdlib.h>
 #include <string.h>
 #include "symtable.h"
+#include "intern.h"
+
+#define SCOPE_INITIAL_CAP 16
+
+/* casilla del nombre en la tabla (ocupada por él, o la libre donde iría) */
+static Symbol* find_slot(Scope* scope, const char* name){
+    unsigned mask = scope->cap - 1;
+    unsigned i = intern_ptr_hash(name) & mask;
+    while(scope->slots[i].name && scope->slots[i].name != name)
+        i = (i + 1) & mask;
+    return &scope->slots[i];
+}
+
+static void grow_scope(Scope* scope){
+    Symbol* old = scope->slots;
+    int old_cap = scope->cap;
+    scope->cap *= 2;
+    scope->slots = calloc(scope->cap, sizeof(Symbol));
+    if(!scope->slots){ perror("calloc"); exit(1); }
+    for(int i=0;i<old_cap;i++){
+        if(old[i].name) *find_slot(scope, old[i].name) = old[i];
+    }
+    free(old);
+}
 
 Scope* create_scope(Scope* parent){
     Scope* s = malloc(sizeof(Scope));
-    s->symbols = NULL;
+    if(!s){ perror("malloc"); exit(1); }
+    s->cap = SCOPE_INITIAL_CAP;
+    s->count = 0;
+    s->slots = calloc(s->cap, sizeof(Symbol));
+    if(!s->slots){ perror("calloc"); exit(1); }
     s->parent = parent;
     return s;
 }
 
 void free_scope(Scope* scope){
-    Symbol* sym = scope->symbols;
-    while(sym){
-        Symbol* tmp = sym;
-        sym = sym->next;
-        free(tmp->name);
-        free(tmp);
-    }
+    free(scope->slots);
     free(scope);
 }
 
-int insert_symbol(Scope* scope, char* name, VarType type){
-    if(lookup_symbol(scope,name)){
-        fprintf(stderr,"Error: simbolo '%s' ya declarado\n",name);
+/* un nombre visible en cualquier scope abierto cuenta como duplicado
+   (devuelve 0 y el que llama informa el error); cada nivel se consulta
+   en O(1) esperado */
+int insert_symbol(Scope* scope, const char* name, VarType type){
+    if((scope->count + 1) * 2 > scope->cap) grow_scope(scope);
+    Symbol* slot = find_slot(scope, name);
+    if(slot->name || lookup_symbol(scope->parent, name))
         return 0;
-    }
-    Symbol* s = malloc(sizeof(Symbol));
-    s->name = strdup(name);
-    s->type = type;
-    s->next = scope->symbols;
-    scope->symbols = s;
+    slot->name = name;
+    slot->type = type;
+    scope->count++;
     return 1;
 }
 
-Symbol* lookup_symbol(Scope* scope, char* name){
+Symbol* lookup_symbol(Scope* scope, const char* name){
     for(Scope* s=scope; s!=NULL; s=s->parent){
-        for(Symbol* sym=s->symbols;sym;sym=sym->next){
-            if(strcmp(sym->name,name)==0) return sym;
-        }
+        Symbol* slot = find_slot(s, name);
+        if(slot->name) return slot;
     }
     return NULL;
 }
-
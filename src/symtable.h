@@ -3,21 +3,24 @@
 #include "ast.h"
 
 typedef struct Symbol {
-    char *name;
+    const char *name;   // internado (NULL = casilla libre)
     VarType type;
-    struct Symbol *next;
 } Symbol;
 
+/* Cada scope tiene su propia tabla hash (direccionamiento abierto, clave =
+   puntero del nombre internado). Un Symbol* devuelto por lookup_symbol es
+   válido hasta la próxima inserción en ese scope. */
 typedef struct Scope {
-    Symbol *symbols;
+    Symbol *slots;
+    int cap;            // potencia de 2
+    int count;
     struct Scope *parent;
 } Scope;
 
 Scope* create_scope(Scope* parent);
 void free_scope(Scope* scope);
 
-int insert_symbol(Scope* scope, char* name, VarType type);
-Symbol* lookup_symbol(Scope* scope, char* name);
+int insert_symbol(Scope* scope, const char* name, VarType type);
+Symbol* lookup_symbol(Scope* scope, const char* name);
 
 #endif
-
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "timereport.h"
+
+static const char* const phase_names[PHASE_COUNT] = {
+    [PHASE_LEX]   = "lex",
+    [PHASE_PARSE] = "parse",
+    [PHASE_SEMA]  = "semantic",
+    [PHASE_FOLD]  = "fold",
+    [PHASE_TAC]   = "tac",
+    [PHASE_ASM]   = "asm",
+};
+
+static const char* const phase_units[PHASE_COUNT] = {
+    [PHASE_LEX]   = "tokens",
+    [PHASE_PARSE] = "nodes",
+    [PHASE_SEMA]  = "checks",
+    [PHASE_FOLD]  = "folded",
+    [PHASE_TAC]   = "instrs",
+    [PHASE_ASM]   = "bytes",
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Heap en uso según el asignador. Es caro comparado con leer el reloj, por
+   eso solo se consulta en los bordes de las fases de primer nivel. */
+static long heap_in_use(void) {
+#ifdef __GLIBC__
+    struct mallinfo2 mi = mallinfo2();
+    return (long)(mi.uordblks + mi.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+static long rss_peak_kb(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return ru.ru_maxrss;
+}
+
+void phase_enter(TimeReport* r, Phase p) {
+    if (!r->enabled) return;
+    double t = now();
+    if (r->depth > 0)
+        r->stats[r->stack[r->depth - 1]].secs += t - r->last_mark;
+    else
+        r->heap_at_enter = heap_in_use();
+    if (r->depth < PHASE_MAX_DEPTH) r->stack[r->depth] = p;
+    r->depth++;
+    r->last_mark = t;
+}
+
+void phase_leave(TimeReport* r) {
+    if (!r->enabled || r->depth == 0) return;
+    double t = now();
+    r->depth--;
+    Phase p = r->stack[r->depth < PHASE_MAX_DEPTH ? r->depth : PHASE_MAX_DEPTH - 1];
+    PhaseStats* s = &r->stats[p];
+    s->secs += t - r->last_mark;
+    if (r->depth == 0) {
+        long heap = heap_in_use();
+        s->heap_delta += heap - r->heap_at_enter;
+        if (heap > s->heap_peak) s->heap_peak = heap;
+        s->rss_peak = rss_peak_kb();
+        s->measured_mem = 1;
+    }
+    r->last_mark = t;
+}
+
+void phase_count(TimeReport* r, Phase p, long n) {
+    if (!r->enabled) return;
+    r->stats[p].count += n;
+}
+
+void time_report_print(TimeReport* r, FILE* out) {
+    double total = 0;
+    for (int i = 0; i < PHASE_COUNT; i++) total += r->stats[i].secs;
+
+    fprintf(out, "\nTiempo de compilación por fase:\n");
+    fprintf(out, " %-10s %10s %6s %10s %-7s %12s %12s %10s\n",
+            "fase", "ms", "%", "cantidad", "", "heap +bytes", "heap pico", "rss KB");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        PhaseStats* s = &r->stats[i];
+        fprintf(out, " %-10s %10.3f %5.1f%% %10ld %-7s",
+                phase_names[i], s->secs * 1e3,
+                total > 0 ? 100.0 * s->secs / total : 0.0,
+                s->count, phase_units[i]);
+        if (s->measured_mem)
+            fprintf(out, " %12ld %12ld %10ld\n", s->heap_delta, s->heap_peak, s->rss_peak);
+        else
+            fprintf(out, " %12s %12s %10s\n", "-", "-", "-");
+    }
+    fprintf(out, " %-10s %10.3f\n", "total", total * 1e3);
+}
+
+static void json_string(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        if ((unsigned char)*s < 0x20) fprintf(out, "\\u%04x", *s);
+        else fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+/* Misma información en JSON, una fase por objeto, para comparar versiones */
+void time_report_json(TimeReport* r, FILE* out, const char* input) {
+    double total = 0;
+    for (int i = 0; i < PHASE_COUNT; i++) total += r->stats[i].secs;
+
+    fprintf(out, "{\n  \"input\": ");
+    json_string(out, input ? input : "<stdin>");
+    fprintf(out, ",\n  \"total_ms\": %.3f,\n  \"phases\": [\n", total * 1e3);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        PhaseStats* s = &r->stats[i];
+        fprintf(out, "    {\"name\": \"%s\", \"ms\": %.3f, \"count\": %ld, \"unit\": \"%s\"",
+                phase_names[i], s->secs * 1e3, s->count, phase_units[i]);
+        if (s->measured_mem)
+            fprintf(out, ", \"heap_delta_bytes\": %ld, \"heap_peak_bytes\": %ld, \"rss_peak_kb\": %ld}",
+                    s->heap_delta, s->heap_peak, s->rss_peak);
+        else
+            fprintf(out, ", \"heap_delta_bytes\": null, \"heap_peak_bytes\": null, \"rss_peak_kb\": null}");
+        fprintf(out, "%s\n", i + 1 < PHASE_COUNT ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,48 @@
+#ifndef TIMEREPORT_H
+#define TIMEREPORT_H
+#include <stdio.h>
+
+/* Fases de la compilación medidas por -ftime-report. LEX y SEMA ocurren
+   dentro de PARSE (las llama el parser), así que se miden anidadas y a
+   PARSE se le cuenta solo el tiempo propio. */
+typedef enum {
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_SEMA,
+    PHASE_FOLD,
+    PHASE_TAC,
+    PHASE_ASM,
+    PHASE_COUNT
+} Phase;
+
+typedef struct PhaseStats {
+    double secs;        // tiempo propio (sin fases anidadas)
+    long count;         // elementos procesados
+    long heap_delta;    // variación del heap en uso durante la fase
+    long heap_peak;     // máximo heap en uso observado al salir de la fase
+    long rss_peak;      // pico de memoria residente del proceso (KB)
+    int measured_mem;   // solo las fases de primer nivel miden memoria
+} PhaseStats;
+
+#define PHASE_MAX_DEPTH 8
+
+/* Mediciones de una compilación. En cero está deshabilitado y cada
+   función retorna enseguida. Heap y RSS son del proceso: con varias
+   compilaciones en paralelo se mezclan. */
+typedef struct TimeReport {
+    int enabled;
+    PhaseStats stats[PHASE_COUNT];
+    Phase stack[PHASE_MAX_DEPTH];
+    int depth;
+    double last_mark;       // instante del último cambio de fase
+    long heap_at_enter;     // heap en uso al entrar a la fase de primer nivel
+} TimeReport;
+
+void phase_enter(TimeReport* r, Phase p);
+void phase_leave(TimeReport* r);
+void phase_count(TimeReport* r, Phase p, long n);   /* suma elementos procesados */
+
+void time_report_print(TimeReport* r, FILE* out);
+void time_report_json(TimeReport* r, FILE* out, const char* input);
+
+#endif
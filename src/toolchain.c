@@ -0,0 +1,85 @@
+#define _GNU_SOURCE     /* pipe2 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "toolchain.h"
+
+extern char** environ;
+
+static const char* tool(const char* env, const char* def) {
+    const char* t = getenv(env);
+    return t && *t ? t : def;
+}
+
+/* corre argv con stdin en in_fd y stderr en err_fd (-1: los heredados) */
+static pid_t spawn_tool(char** argv, int in_fd, int err_fd, FILE* diag) {
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    if (in_fd >= 0) posix_spawn_file_actions_adddup2(&fa, in_fd, STDIN_FILENO);
+    if (err_fd >= 0 && err_fd != STDERR_FILENO)
+        posix_spawn_file_actions_adddup2(&fa, err_fd, STDERR_FILENO);
+    pid_t pid;
+    int r = posix_spawnp(&pid, argv[0], &fa, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&fa);
+    if (r != 0) {
+        fprintf(diag, "Error: no se pudo ejecutar %s: %s\n", argv[0], strerror(r));
+        return -1;
+    }
+    return pid;
+}
+
+pid_t assembler_start(const char* obj, int err_fd, FILE* diag, int* in_fd) {
+    /* close-on-exec: con varias entradas a la vez, ningún otro ensamblador
+       debe heredar este pipe o no vería nunca el fin de su entrada */
+    int p[2];
+    if (pipe2(p, O_CLOEXEC) != 0) {
+        fprintf(diag, "Error: pipe: %s\n", strerror(errno));
+        return -1;
+    }
+    char* argv[] = { (char*)tool("AS", "as"), "-o", (char*)obj, NULL };
+    pid_t pid = spawn_tool(argv, p[0], err_fd, diag);
+    close(p[0]);
+    if (pid < 0) {
+        close(p[1]);
+        return -1;
+    }
+    *in_fd = p[1];
+    return pid;
+}
+
+int tool_wait(pid_t pid, const char* name, FILE* diag) {
+    int st;
+    while (waitpid(pid, &st, 0) < 0) {
+        if (errno != EINTR) {
+            fprintf(diag, "Error: %s: %s\n", name, strerror(errno));
+            return -1;
+        }
+    }
+    if (WIFEXITED(st) && WEXITSTATUS(st) == 0) return 0;
+    if (WIFEXITED(st))
+        fprintf(diag, "Error: %s terminó con código %d\n", name, WEXITSTATUS(st));
+    else
+        fprintf(diag, "Error: %s terminó por la señal %d\n", name, WTERMSIG(st));
+    return -1;
+}
+
+int link_executable(const char* exe, char** objs, int nobjs,
+                    const char** extra, int nextra, int err_fd, FILE* diag) {
+    char** argv = malloc(sizeof(char*) * (nobjs + nextra + 4));
+    int n = 0;
+    argv[n++] = (char*)tool("CC", "cc");
+    argv[n++] = "-o";
+    argv[n++] = (char*)exe;
+    for (int i = 0; i < nobjs; i++) argv[n++] = objs[i];
+    for (int i = 0; i < nextra; i++) argv[n++] = (char*)extra[i];
+    argv[n] = NULL;
+    pid_t pid = spawn_tool(argv, -1, err_fd, diag);
+    int r = pid < 0 ? -1 : tool_wait(pid, argv[0], diag);
+    free(argv);
+    return r;
+}
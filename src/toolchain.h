@@ -0,0 +1,25 @@
+#ifndef TOOLCHAIN_H
+#define TOOLCHAIN_H
+#include <stdio.h>
+#include <sys/types.h>
+
+/* ---------- Ensamblador y enlazador del sistema ----------
+ * Con -o el assembly no pasa por un .s: cada compilación escribe en un pipe
+ * a `as` (o $AS), que corre mientras se compilan las demás entradas, y al
+ * final `cc` (o $CC) enlaza los objetos con el runtime y genera el
+ * ejecutable. Los mensajes de las herramientas van a err_fd.
+ */
+
+/* lanza el ensamblador que escribe obj leyendo de un pipe; devuelve su
+   pid (-1 si no se pudo, informado en diag) y en *in_fd el extremo de
+   escritura del pipe */
+pid_t assembler_start(const char* obj, int err_fd, FILE* diag, int* in_fd);
+
+/* espera a la herramienta; 0 si terminó bien, si no lo informa en diag */
+int tool_wait(pid_t pid, const char* name, FILE* diag);
+
+/* enlaza objs y los objetos/bibliotecas extra (el runtime) en exe */
+int link_executable(const char* exe, char** objs, int nobjs,
+                    const char** extra, int nextra, int err_fd, FILE* diag);
+
+#endif
@@ -0,0 +1,10 @@
+Program
+{
+integer a = 3;
+integer b = a + 1;
+
+integer main()
+{
+    return b;
+}
+}
@@ -0,0 +1,15 @@
+Program
+{
+integer doble(integer t1)
+{
+    integer t2 = t1 + t1;
+    return t2;
+}
+
+void main()
+{
+    integer t0 = 4;
+    t0 = t0 * 2;
+    return;
+}
+}